@@ -96,8 +96,9 @@ bool AudioEngine::loadJetpackSoundEffect(const std::string &filename)
     return true;
 }
 
-bool AudioEngine::playStarSound(bool which) const
+bool AudioEngine::playStarSound(unsigned which) const
 {
+    if (which >= NUM_STAR_SOUNDS) return false;
     return Mix_PlayChannel(-1, star_effects_[which], 0) == 0;
 }
 
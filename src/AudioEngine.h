@@ -10,6 +10,8 @@
  */
 #pragma once
 
+#include "StarKind.h"
+
 #include <SDL_mixer.h>
 
 #include <string>
@@ -54,10 +56,11 @@ public:
     bool loadJetpackSoundEffect(const std::string &filename);
 
     /*!
-     * \brief Attempts to play the star sound effect
+     * \brief Attempts to play a star sound effect
+     * \param which 0 = the sound every star makes, 1 = the extra sound a moving star makes; see StarBehaviour::sounds
      * \return true on success
      */
-    bool playStarSound(bool movingStar = false) const;
+    bool playStarSound(unsigned which = 0) const;
     bool playJetpackSound() const;
 
     /// Returns the age in milliseconds of the last time we played the jetpack sound
@@ -81,7 +84,7 @@ private:
     Mix_Music *background_music_{};
 
     /// Star sound effect
-    Mix_Chunk *star_effects_[2] = {};
+    Mix_Chunk *star_effects_[NUM_STAR_SOUNDS] = {};
 
     /// Jetpack sound effect
     Mix_Chunk *jetpack_effect_{};
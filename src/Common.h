@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 // IS_IOS detection
 #if __has_include(<TargetConditionals.h>) // macOS, iOS, etc
 #  include <TargetConditionals.h>
@@ -12,3 +14,8 @@
 #endif
 
 inline constexpr double PHYSICS_RATE = 1000.0 / 24.0; /* internal physics originally assumed this framerate */
+inline constexpr unsigned DEFAULT_FRAME_RATE = 60; /* default desired game framerate, see FramePacer */
+inline constexpr unsigned DEFAULT_SIM_RATE = 120; /* default simulation ticks per second, see FixedTimestep */
+
+using ImageId = std::uint16_t; /* handle of an image, see GraphicsEngine::loadImage() */
+inline constexpr ImageId NO_IMAGE = ImageId(-1); /* the ImageId of no image */
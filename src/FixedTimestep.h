@@ -0,0 +1,73 @@
+/*!
+ * \file FixedTimestep.h
+ * \brief File containing the FixedTimestep class
+ *
+ * \copyright GNU Public License
+ */
+#pragma once
+
+#include "Common.h"
+
+#include <algorithm>
+#include <cassert>
+
+/*!
+ * \class FixedTimestep
+ * \brief Accumulates wall-clock time and hands it out as whole, fixed-size simulation ticks
+ *
+ * The simulation always advances by exactly tickDT(), no matter how fast or slow frames are presented.
+ * Whatever time is left over after the last whole tick is exposed as alpha(), which the renderer uses to
+ * interpolate between the previous and current simulation states.
+ */
+class FixedTimestep
+{
+public:
+    /*!
+     * \brief Constructor
+     * \param tick_rate simulation ticks per second
+     * \param max_ticks_per_frame upper bound on ticks run for a single frame; excess time is dropped so that
+     *        a very long frame (window drag, browser tab hidden, etc) slows the game down rather than
+     *        making it run a huge burst of ticks (or one huge Euler step).
+     */
+    explicit FixedTimestep(unsigned tick_rate, unsigned max_ticks_per_frame = 8)
+        : tick_rate_(std::max(tick_rate, 1u)), tick_ms_(1000.0 / tick_rate_),
+          max_ticks_(std::max(max_ticks_per_frame, 1u)) {}
+
+    /// Forget any accumulated time (e.g. after a pause or a game restart)
+    void reset() { accum_ms_ = 0.0; }
+
+    /*!
+     * \brief Feed elapsed wall-clock time into the accumulator
+     * \param elapsed_ms milliseconds since the last call
+     * \return the number of whole ticks the caller should now run
+     */
+    unsigned advance(double elapsed_ms) {
+        accum_ms_ += std::max(elapsed_ms, 0.0);
+        unsigned n = static_cast<unsigned>(accum_ms_ / tick_ms_);
+        if (n > max_ticks_) {
+            n = max_ticks_;
+            accum_ms_ = 0.0; // drop the backlog
+        } else
+            accum_ms_ -= n * tick_ms_;
+        assert(accum_ms_ >= 0.0);
+        return n;
+    }
+
+    /// \return how far we are between the last tick and the next one, in the range [0, 1)
+    double alpha() const { return std::clamp(accum_ms_ / tick_ms_, 0.0, 1.0); }
+
+    /// \return simulation ticks per second
+    unsigned tickRate() const { return tick_rate_; }
+
+    /// \return the length of one tick in milliseconds
+    double tickMS() const { return tick_ms_; }
+
+    /// \return the length of one tick on the physics timescale (1.0 == 1 frame at PHYSICS_RATE)
+    double tickDT() const { return tick_ms_ / PHYSICS_RATE; }
+
+private:
+    const unsigned tick_rate_;
+    const double tick_ms_;
+    const unsigned max_ticks_;
+    double accum_ms_ = 0.0;
+};
@@ -0,0 +1,73 @@
+/*!
+ * \file FramePacer.cpp
+ * \brief File containing the FramePacer source code
+ *
+ * \copyright GNU Public License
+ */
+#include "FramePacer.h"
+
+#include <algorithm>
+
+inline constexpr double MIN_SLEEP_MARGIN_MS = 0.25;
+inline constexpr double MAX_SLEEP_MARGIN_MS = 4.0;
+
+FramePacer::FramePacer(double target_rate, bool external_pacing)
+    : freq_(SDL_GetPerformanceFrequency()), target_rate_(target_rate), external_pacing_(external_pacing)
+{
+    setTargetRate(target_rate);
+}
+
+void FramePacer::reset()
+{
+    last_frame_ = SDL_GetPerformanceCounter();
+    next_deadline_ = last_frame_ + period_;
+    frame_ms_ = lateness_ms_ = max_lateness_ms_ = sum_lateness_ms_ = 0.0;
+    frames_ = 0;
+}
+
+void FramePacer::setTargetRate(double target_rate)
+{
+    target_rate_ = std::max(target_rate, 1.0);
+    period_ = static_cast<Uint64>(freq_ / target_rate_);
+    reset();
+}
+
+double FramePacer::waitForNextFrame()
+{
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    if (!external_pacing_) {
+        if (now < next_deadline_) {
+            /* Sleep for most of the remaining time */
+            const double remaining_ms = toMS(next_deadline_ - now);
+            if (const Uint32 sleep_ms = static_cast<Uint32>(std::max(remaining_ms - sleep_margin_ms_, 0.0))) {
+                const Uint64 before = now;
+                SDL_Delay(sleep_ms);
+                now = SDL_GetPerformanceCounter();
+                // learn how much SDL_Delay() oversleeps on this machine, and stop sleeping that much earlier
+                const double overslept_ms = toMS(now - before) - sleep_ms;
+                sleep_margin_ms_ = std::clamp(sleep_margin_ms_ * 0.9 + (overslept_ms + MIN_SLEEP_MARGIN_MS) * 0.1,
+                                              MIN_SLEEP_MARGIN_MS, MAX_SLEEP_MARGIN_MS);
+            }
+            /* Spin for the rest */
+            while (now < next_deadline_)
+                now = SDL_GetPerformanceCounter();
+        }
+        lateness_ms_ = toMS(now - next_deadline_);
+        next_deadline_ += period_;
+        // more than a whole frame behind: start a new schedule rather than rushing to catch up
+        if (now > next_deadline_)
+            next_deadline_ = now + period_;
+    } else {
+        lateness_ms_ = std::max(toMS(now - last_frame_) - periodMS(), 0.0);
+    }
+
+    frame_ms_ = toMS(now - last_frame_);
+    last_frame_ = now;
+
+    max_lateness_ms_ = std::max(max_lateness_ms_, lateness_ms_);
+    sum_lateness_ms_ += lateness_ms_;
+    ++frames_;
+
+    return frame_ms_;
+}
@@ -0,0 +1,83 @@
+/*!
+ * \file FramePacer.h
+ * \brief File containing the FramePacer class Header
+ *
+ * \copyright GNU Public License
+ */
+#pragma once
+
+#include <SDL.h>
+
+/*!
+ * \class FramePacer
+ * \brief Paces the main loop to a target frame rate using the high-resolution performance counter
+ *
+ * Frame deadlines are kept on an absolute schedule (deadline += period) so rounding never accumulates into a
+ * lower real rate. Waiting is hybrid: SDL_Delay() for the bulk of the wait, stopping short by a margin that is
+ * learned from how much SDL_Delay() actually oversleeps on this machine, then spinning until the deadline.
+ *
+ * If presentation is vsync-driven (or the platform paces us, like the browser does), the pacer does not wait
+ * at all and only measures.
+ */
+class FramePacer
+{
+public:
+    /*!
+     * \brief Constructor
+     * \param target_rate desired frames per second
+     * \param external_pacing true if something else (vsync, the browser) already paces frames; we only measure
+     */
+    explicit FramePacer(double target_rate, bool external_pacing = false);
+
+    /// Start a fresh schedule from "now" (e.g. after a game restart)
+    void reset();
+
+    /// Change the target frame rate
+    void setTargetRate(double target_rate);
+
+    /// \return the target frame rate
+    double targetRate() const { return target_rate_; }
+
+    /// \return the target frame period in milliseconds
+    double periodMS() const { return 1000.0 / target_rate_; }
+
+    /// Switch between waiting for deadlines ourselves (false) and only measuring (true)
+    void setExternalPacing(bool b) { external_pacing_ = b; reset(); }
+
+    /// \return true if we are only measuring
+    bool externalPacing() const { return external_pacing_; }
+
+    /*!
+     * \brief Waits until the next frame is due
+     * \return milliseconds elapsed since the previous call (or since reset())
+     */
+    double waitForNextFrame();
+
+    /// \return the duration of the last frame in milliseconds
+    double lastFrameMS() const { return frame_ms_; }
+
+    /// \return how late (in milliseconds) the last frame started relative to its deadline
+    double lastLatenessMS() const { return lateness_ms_; }
+
+    /// \return the worst lateness seen since reset()
+    double maxLatenessMS() const { return max_lateness_ms_; }
+
+    /// \return the average lateness since reset()
+    double meanLatenessMS() const { return frames_ ? sum_lateness_ms_ / frames_ : 0.0; }
+
+private:
+    double toMS(Uint64 counter_diff) const { return counter_diff * 1000.0 / freq_; }
+
+    const Uint64 freq_;
+    double target_rate_;
+    bool external_pacing_;
+    Uint64 period_{};          ///< target frame period, in performance counter units
+    Uint64 next_deadline_{};   ///< when the next frame is due, in performance counter units
+    Uint64 last_frame_{};      ///< when the last frame started, in performance counter units
+    double sleep_margin_ms_ = 2.0; ///< how early we stop sleeping and start spinning; adapts over time
+    double frame_ms_ = 0.0;
+    double lateness_ms_ = 0.0;
+    double max_lateness_ms_ = 0.0;
+    double sum_lateness_ms_ = 0.0;
+    unsigned long frames_ = 0;
+};
@@ -0,0 +1,80 @@
+/*!
+ * \file FrameTimeHistogram.cpp
+ * \brief File containing the FrameTimeHistogram source code
+ *
+ * \copyright GNU Public License
+ */
+#include "FrameTimeHistogram.h"
+
+#include "tinyformat.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+/* static */
+unsigned FrameTimeHistogram::bucketFor(std::uint64_t us)
+{
+    if (us < SUB_BUCKETS)
+        return unsigned(us); // values below SUB_BUCKETS get a bucket each
+    const unsigned msb = std::min(unsigned(std::bit_width(us)) - 1, OCTAVES - 1);
+    const unsigned sub = unsigned(std::min(us >> (msb - SUB_BITS), std::uint64_t(2 * SUB_BUCKETS - 1))) - SUB_BUCKETS;
+    return (msb - SUB_BITS + 1) * SUB_BUCKETS + sub;
+}
+
+/* static */
+std::uint64_t FrameTimeHistogram::bucketUpperUS(unsigned bucket)
+{
+    if (bucket < SUB_BUCKETS)
+        return bucket + 1;
+    const unsigned msb = bucket / SUB_BUCKETS + SUB_BITS - 1;
+    const unsigned sub = bucket % SUB_BUCKETS;
+    return (std::uint64_t(SUB_BUCKETS + sub + 1)) << (msb - SUB_BITS);
+}
+
+void FrameTimeHistogram::record(double frame_ms)
+{
+    frame_ms = std::max(frame_ms, 0.0);
+    ++buckets_[bucketFor(static_cast<std::uint64_t>(frame_ms * 1000.0))];
+    ++count_;
+    sum_ms_ += frame_ms;
+    max_ms_ = std::max(max_ms_, frame_ms);
+    if (overrun_ms_ > 0.0 && frame_ms > overrun_ms_)
+        ++overruns_;
+}
+
+void FrameTimeHistogram::clear()
+{
+    buckets_.fill(0);
+    count_ = overruns_ = 0;
+    sum_ms_ = max_ms_ = 0.0;
+}
+
+double FrameTimeHistogram::percentileMS(double p) const
+{
+    if (!count_)
+        return 0.0;
+    const auto rank = static_cast<std::uint64_t>(std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * count_));
+    std::uint64_t seen = 0;
+    for (unsigned i = 0; i < NUM_BUCKETS; ++i)
+        if ((seen += buckets_[i]) >= std::max<std::uint64_t>(rank, 1))
+            return std::min(bucketUpperUS(i) / 1000.0, max_ms_);
+    return max_ms_;
+}
+
+std::string FrameTimeHistogram::toJSON() const
+{
+    std::string ret = strprintf("{\"frames\": %d, \"mean_ms\": %.3f, \"p50_ms\": %.3f, \"p95_ms\": %.3f, "
+                                "\"p99_ms\": %.3f, \"max_ms\": %.3f, \"overrun_ms\": %.3f, \"overruns\": %d, "
+                                "\"buckets\": [",
+                                count_, meanMS(), percentileMS(50), percentileMS(95), percentileMS(99), maxMS(),
+                                overrun_ms_, overruns_);
+    const char *sep = "";
+    for (unsigned i = 0; i < NUM_BUCKETS; ++i)
+        if (buckets_[i]) {
+            ret += strprintf("%s[%.3f, %d]", sep, bucketUpperUS(i) / 1000.0, buckets_[i]);
+            sep = ", ";
+        }
+    ret += "]}";
+    return ret;
+}
@@ -0,0 +1,75 @@
+/*!
+ * \file FrameTimeHistogram.h
+ * \brief File containing the FrameTimeHistogram class Header
+ *
+ * \copyright GNU Public License
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+/*!
+ * \class FrameTimeHistogram
+ * \brief Fixed-memory histogram of frame times with logarithmic buckets
+ *
+ * Times are bucketed in microseconds: each power of two is split into SUB_BUCKETS linear buckets, so any value
+ * is known to within 1/SUB_BUCKETS (~6%) while covering everything from 1 us to hours in about 600 counters.
+ * Recording is O(1) and never allocates.
+ */
+class FrameTimeHistogram
+{
+public:
+    /*!
+     * \brief Constructor
+     * \param overrun_ms frames taking longer than this many milliseconds are counted as budget overruns
+     */
+    explicit FrameTimeHistogram(double overrun_ms = 0.0) : overrun_ms_(overrun_ms) {}
+
+    /// Add a frame time
+    void record(double frame_ms);
+
+    /// Forget all recorded frames (the overrun threshold is kept)
+    void clear();
+
+    /// \return the number of frames recorded
+    std::uint64_t count() const { return count_; }
+
+    /// \return the number of frames that took longer than the overrun threshold
+    std::uint64_t overruns() const { return overruns_; }
+
+    /// \return the overrun threshold in milliseconds
+    double overrunMS() const { return overrun_ms_; }
+
+    /// \return the mean frame time in milliseconds
+    double meanMS() const { return count_ ? sum_ms_ / count_ : 0.0; }
+
+    /// \return the longest frame time in milliseconds (exact, not bucketed)
+    double maxMS() const { return max_ms_; }
+
+    /*!
+     * \param p the percentile, in the range [0, 100]
+     * \return the frame time in milliseconds that p percent of frames were at or below (bucket upper bound)
+     */
+    double percentileMS(double p) const;
+
+    /// \return all of the above (plus the non-empty buckets) as a JSON object
+    std::string toJSON() const;
+
+private:
+    static constexpr unsigned SUB_BITS = 4;
+    static constexpr unsigned SUB_BUCKETS = 1u << SUB_BITS;
+    static constexpr unsigned OCTAVES = 36; ///< values up to 2^36 us (~19 hours); anything longer goes in the last
+    static constexpr unsigned NUM_BUCKETS = SUB_BUCKETS + (OCTAVES - SUB_BITS) * SUB_BUCKETS;
+
+    static unsigned bucketFor(std::uint64_t us);
+    static std::uint64_t bucketUpperUS(unsigned bucket);
+
+    std::array<std::uint32_t, NUM_BUCKETS> buckets_{};
+    std::uint64_t count_ = 0;
+    std::uint64_t overruns_ = 0;
+    double sum_ms_ = 0.0;
+    double max_ms_ = 0.0;
+    double overrun_ms_;
+};
@@ -11,15 +11,20 @@
 #include "Game.h"
 
 #include "AudioEngine.h"
-#include "BasicStar.h"
 #include "GraphicsEngine.h"
 #include "Highscore.h"
-#include "MovingStar.h"
+#include "Profiler.h"
+#include "Replay.h"
+#include "Rewind.h"
 #include "tinyformat.h"
 
 #include <cassert>
 #include <cstdlib>
+#include <fstream>
 #include <iostream>
+#include <random>
+#include <string_view>
+#include <vector>
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten.h>
@@ -33,9 +38,9 @@ void emscripten_set_main_loop_arg(Args && ...args [[maybe_unused]]) {
 }
 #endif // __EMSCRIPTEN__
 
-inline constexpr unsigned FRAME_RATE = 60; /* desired game framerate (non-EMSCRIPTEN only) */
-inline constexpr unsigned REFRESH_RATE = 1000 / FRAME_RATE;
 inline constexpr unsigned JETPACK_SOUND_DURATION_MS = 388;
+inline constexpr double FRAME_OVERRUN_FACTOR = 1.5; /* a frame this many times its budget surely missed a present */
+inline constexpr unsigned FRAME_STATS_OVERLAY_MS = 1000; /* the FPS overlay shows stats over windows this long */
 
 struct Game::GameOver
 {
@@ -49,19 +54,32 @@ struct Game::GameOver
 };
 
 
-Game::Game()
+Game::Game(const Options &options)
+    : fixed_seed_(options.seed), record_file_(options.record_file),
+      replay_(options.replay_file.empty() ? nullptr : std::make_unique<ReplayReader>(options.replay_file)),
+      pacer_(options.frame_rate, IS_EMSCRIPTEN /* the browser paces us */),
+      frame_stats_(pacer_.periodMS() * FRAME_OVERRUN_FACTOR),
+      recent_frame_stats_(frame_stats_.overrunMS()), shown_frame_stats_(frame_stats_.overrunMS()),
+      frame_stats_file_(options.frame_stats_file), trace_file_(options.trace_file),
+      timestep_(replay_ && replay_->ok() ? replay_->header().sim_rate : options.sim_rate), hud_(Highscore::ROWS)
 {
+    if (replay_ && !replay_->ok())
+        FatalError(replay_->error(), "Failed to Load Replay");
+
     /* Initialize graphics */
     if constexpr (IS_IOS) {
-        graphics_ = std::make_unique<GraphicsEngine>("Jumpman" /* Title */, 375 /* Screen width */, 667 /* Screen height */);
+        graphics_ = std::make_unique<GraphicsEngine>("Jumpman" /* Title */, 375 /* Screen width */, 667 /* Screen height */,
+                                                     GraphicsEngine::Target::Window, options.render_backend);
     } else {
-        graphics_ = std::make_unique<GraphicsEngine>("Jumpman" /* Title */, 1000 /* Screen width */, 600 /* Screen height */);
+        graphics_ = std::make_unique<GraphicsEngine>("Jumpman" /* Title */, 1000 /* Screen width */, 600 /* Screen height */,
+                                                     GraphicsEngine::Target::Window, options.render_backend);
     }
 
-    /* Load images from disk */
-    if (graphics_->loadImage("player") == false || graphics_->loadImage("basic_star") == false ||
-        graphics_->loadImage("moving_star") == false) {
-        FatalError(graphics_->getLastError(), "Failed to Load Image");
+    if (options.vsync && !IS_EMSCRIPTEN) {
+        if (graphics_->setVSync(true))
+            pacer_.setExternalPacing(true);
+        else
+            Warning("VSync is not supported by the graphics backend, using timed frame pacing");
     }
 
     /* Initialize audio */
@@ -71,7 +89,28 @@ Game::Game()
     audio_->loadStarSoundEffect("audio/starsound1.wav", "audio/starsound2.wav");
     audio_->startPlayingBackgroundMusic(50);
 
-    player_ = std::make_unique<Player>(graphics_->screen_width());
+    if (replay_) {
+        // the recorded play area is part of the game rules, so it wins over the size of our window
+        const ReplayHeader &hdr = replay_->header();
+        if (hdr.screen_width != graphics_->screen_width() || hdr.screen_height != graphics_->screen_height())
+            Warning(strprintf("Replay was recorded at %ix%i, drawing will be off", hdr.screen_width, hdr.screen_height));
+        sim_ = std::make_unique<Simulation>(hdr.screen_width, hdr.screen_height);
+    } else {
+        sim_ = std::make_unique<Simulation>(graphics_->screen_width(), graphics_->screen_height());
+        rewind_ = std::make_unique<Rewind>(timestep_.tickRate());
+    }
+
+    /* Load images from disk; from here on they are drawn by id */
+    bool images_loaded = true;
+    Player &player = sim_->player();
+    player.setImage(graphics_->loadImage(player.filename()));
+    images_loaded = images_loaded && player.image() != NO_IMAGE;
+    for (std::size_t kind = 0; kind < NUM_STAR_KINDS; ++kind) {
+        star_images_[kind] = graphics_->loadImage(STAR_BEHAVIOURS[kind].filename);
+        images_loaded = images_loaded && star_images_[kind] != NO_IMAGE;
+    }
+    if (!images_loaded)
+        FatalError(graphics_->getLastError(), "Failed to Load Image");
 
     // If we are running under emscripten, set up the /data mountpoint
 #ifdef __EMSCRIPTEN__
@@ -103,58 +142,64 @@ void Game::Warning(const std::string &msg)
     std::cerr << "Warning: " << msg << "\n";
 }
 
-/// Get a random number generator for the range [a, b]
-/* static */
-Game::RandGen Game::GetRandGen(int from, int to)
-{
-    static std::random_device rd;  // Will be used to obtain a seed for the random number engine
-    static std::mt19937 gen(rd()); // Standard mersenne_twister_engine seeded with rd()
-    assert(to >= from);
-    return RandGen(gen, from, to);
-}
-
 auto Game::runStep() -> RunStepResult
 {
     using R = RunStepResult;
 
-    unsigned tdiff = SDL_GetTicks() - ticks_last_;
-
-    // throttle game frame-rate (non-emscripten mode only)
-    if constexpr (!IS_EMSCRIPTEN) {
-        if (tdiff < REFRESH_RATE) {
-            SDL_Delay(REFRESH_RATE - tdiff);
-            tdiff = SDL_GetTicks() - ticks_last_;
-        }
+    // throttle game frame-rate (unless vsync or the browser is doing it for us)
+    double tdiff;
+    {
+        PROFILE_ZONE("waitForNextFrame");
+        tdiff = pacer_.waitForNextFrame();
     }
 
-    // take rolling average of last 10 values
-    fps_ = fps_ * 10.0 + 1000.0 / tdiff;
-    fps_ /= 11.0;
-
-    ticks_last_ = SDL_GetTicks();
+    PROFILE_ZONE("runStep");
+    recordFrameTime(tdiff);
 
-    if (!game_over) {
+    const bool was_rewinding = rewinding_;
+    rewinding_ = wantsRewind();
+    if (was_rewinding && !rewinding_ && !game_over && !replay_)
+        followHeldKeys();
+    if (rewinding_) {
+        /* Holding 'r' runs the game backwards, as fast as it went forwards */
+        if (!game_over && handlePlayerInput())
+            return R::Quit; // user quit
+        rewind(timestep_.advance(tdiff));
+    } else if (!game_over) {
         /* Normal gameplay */
 
         if (handlePlayerInput())
             return R::Quit; // user quit
 
         if (!paused_) {
-            if (letObjectsInteract(tdiff / PHYSICS_RATE) == 1) {
-                // indicates game over if this is set
+            /* Run as many fixed-size simulation ticks as the elapsed time calls for */
+            for (unsigned n = timestep_.advance(tdiff); n > 0; --n) {
+                if (replay_)
+                    applyReplayInputs();
+                const int died = letObjectsInteract(timestep_.tickDT());
+                if (rewind_)
+                    rewind_->ticked(*sim_);
+                if (died == 1) {
+                    if (!onPlayerDied())
+                        return R::Quit; // replay finished
+                    // indicates game over if this is set
 #ifdef __EMSCRIPTEN__
-                game_over = std::make_unique<GameOver>("/persistent_data/highscore", []{
-                    // sync
-                    EM_ASM(FS.syncfs(false, function (err) {}););
-                });
+                    game_over = std::make_unique<GameOver>("/persistent_data/highscore", []{
+                        // sync
+                        EM_ASM(FS.syncfs(false, function (err) {}););
+                    });
 #else
-                game_over = std::make_unique<GameOver>(".highscore");
+                    game_over = std::make_unique<GameOver>(".highscore");
 #endif
+                    break;
+                }
             }
-        }
+        } else
+            timestep_.reset(); // don't let time spent paused turn into a burst of ticks on resume
     }
 
-    drawObjectsToScreen();
+    // when the simulation isn't advancing there is nothing to interpolate towards
+    drawObjectsToScreen(game_over || paused_ || rewinding_ ? 1.0 : timestep_.alpha());
 
     if (game_over) {
         /* Draw game over screen */
@@ -171,15 +216,132 @@ auto Game::runStep() -> RunStepResult
 
 void Game::reset()
 {
-    /* Reset Player */
-    player_->reset();
-
-    /* Reset Starlist */
-    star_list_.clear();
+    /* Reset Player and Starlist */
+    std::uint64_t seed;
+    if (replay_)
+        seed = replay_->header().seed;
+    else if (fixed_seed_)
+        seed = *fixed_seed_;
+    else {
+        std::random_device rd;
+        seed = (std::uint64_t(rd()) << 32) | rd();
+    }
+    sim_->reset(seed);
+    if (rewind_)
+        rewind_->start(*sim_);
+    rewound_ = false;
+
+    /* Start a new recording (this overwrites the previous game's) */
+    if (!record_file_.empty() && !replay_) {
+        recorder_ = std::make_unique<ReplayWriter>(record_file_, ReplayHeader{seed, timestep_.tickRate(),
+                                                                              sim_->screen_width(),
+                                                                              sim_->screen_height()});
+        if (!recorder_->ok())
+            Warning("Cannot write to replay file: " + record_file_);
+    }
 
     game_over.reset();
 
-    ticks_last_ = start_ticks_ = SDL_GetTicks();
+    timestep_.reset();
+    pacer_.reset();
+
+    start_ticks_ = SDL_GetTicks();
+}
+
+void Game::saveState(Snapshot &out) const
+{
+    SnapshotWriter w(out);
+    w.put(paused_);
+    sim_->save(w);
+}
+
+bool Game::restoreState(const Snapshot &in)
+{
+    if (replay_)
+        return false;
+    SnapshotReader r(in);
+    bool paused = false;
+    if (!r.get(paused) || !sim_->restore(r))
+        return false;
+    wentBackInTime();
+    if (rewind_)
+        rewind_->start(*sim_);
+    if (paused != paused_)
+        paused_ = audio_->togglePausePlayBackgroundMusic();
+    timestep_.reset();
+    return true;
+}
+
+bool Game::wantsRewind() const
+{
+    // on the high score screen, 'r' is a letter of the player's name
+    if (!rewind_ || paused_ || (game_over && game_over->state == GameOver::InputHS))
+        return false;
+    return SDL_GetKeyboardState(nullptr)[SDL_SCANCODE_R];
+}
+
+void Game::rewind(unsigned ticks)
+{
+    if (ticks == 0 || rewind_->stepBack(*sim_, ticks) == 0)
+        return;
+    rewound_ = true;
+    wentBackInTime();
+}
+
+void Game::followHeldKeys()
+{
+    const auto *state = SDL_GetKeyboardState(nullptr);
+    const bool left = state[SDL_SCANCODE_LEFT], right = state[SDL_SCANCODE_RIGHT];
+    if (left && right)
+        return; // there is no telling which was pressed last, so leave the player going the way the history has it
+    const event_t event = left ? LEFT : right ? RIGHT : STILL;
+    if (recorder_) {
+        if (const auto rev = toReplayEvent(event))
+            recorder_->add(sim_->tick(), *rev);
+    }
+    applyInput(left ? Simulation::Input::Left : right ? Simulation::Input::Right : Simulation::Input::Still);
+}
+
+void Game::wentBackInTime()
+{
+    if (recorder_) {
+        Warning("Stopped recording to " + record_file_ + ": the game went back in time");
+        recorder_.reset();
+    }
+    if (!sim_->over())
+        game_over.reset();
+}
+
+void Game::recordFrameTime(double frame_ms)
+{
+    frame_stats_.record(frame_ms);
+    recent_frame_stats_.record(frame_ms);
+    if (const unsigned now = SDL_GetTicks(); now - recent_frame_stats_start_ >= FRAME_STATS_OVERLAY_MS) {
+        shown_frame_stats_ = recent_frame_stats_;
+        recent_frame_stats_.clear();
+        recent_frame_stats_start_ = now;
+    }
+}
+
+void Game::dumpTrace() const
+{
+    if constexpr (Profiler::Enabled) {
+        if (Profiler::WriteChromeTrace(trace_file_))
+            std::cerr << "Wrote profiler trace to " << trace_file_ << "\n";
+        else
+            Warning("Cannot write profiler trace to: " + trace_file_);
+    }
+}
+
+void Game::dumpFrameStats() const
+{
+    const std::string json = frame_stats_.toJSON();
+    if (frame_stats_file_.empty()) {
+        std::cerr << json << "\n";
+    } else if (std::ofstream f(frame_stats_file_); f) {
+        f << json << "\n";
+    } else
+        Warning("Cannot write frame stats to: " + frame_stats_file_);
 }
 
 int Game::run()
@@ -196,6 +358,8 @@ int Game::run()
             if (retval == R::Restart) // retval == 2 indicates game restart
                 reset();
         } while (retval == R::Continue || retval == R::Restart);
+        dumpFrameStats();
+        dumpTrace();
         return retval == R::Error ? 1 : 0;
     } else {
         // EMSCRIPTEN, use the weird callback mechanism to continually pass control to JS and not hang browser.
@@ -219,23 +383,76 @@ int Game::run()
     }
 }
 
+/* static */
+auto Game::toReplayEvent(event_t event) -> std::optional<ReplayEvent>
+{
+    switch (event) {
+    case LEFT: return ReplayEvent::Left;
+    case RIGHT: return ReplayEvent::Right;
+    case UP: return ReplayEvent::Up;
+    case STILL: return ReplayEvent::Still;
+    case PAUSEPLAY: return ReplayEvent::PausePlay;
+    default: return std::nullopt;
+    }
+}
+
+void Game::applyReplayInputs()
+{
+    for (const ReplayReader::Entry *e; (e = replay_->peek()) && e->tick <= sim_->tick(); replay_->pop())
+        if (const auto input = toSimInput(e->event))
+            sim_->handleInput(*input);
+    if (!replay_->ok())
+        Warning(replay_->error());
+}
+
+bool Game::onPlayerDied()
+{
+    const std::size_t score = sim_->player().score();
+    if (recorder_)
+        recorder_->finish(sim_->tick(), score);
+    if (!replay_)
+        return true;
+
+    // a replay does not go into the high scores; report how it went and quit
+    const auto &end = replay_->end();
+    if (const ReplayReader::Entry *e = replay_->peek())
+        Warning(strprintf("Replay diverged: died at tick %i with score %i, with recorded inputs still to come at "
+                          "tick %i", sim_->tick(), score, e->tick));
+    else if (!end)
+        Warning(strprintf("Replay not verified: the recording has no end record (the game was quit before it "
+                          "ended); died at tick %i with score %i", sim_->tick(), score));
+    else if (end->score != score || end->tick != sim_->tick())
+        Warning(strprintf("Replay diverged: recorded score %i at tick %i, got score %i at tick %i",
+                          end->score, end->tick, score, sim_->tick()));
+    else
+        std::cout << "Replay finished: score " << score << " at tick " << sim_->tick() << "\n";
+    return false;
+}
+
 bool Game::handlePlayerInput()
 {
+    PROFILE_ZONE("handlePlayerInput");
     event_t event = NOTHING;
     while (auto optEvent = getEvent()) {
         event = *optEvent;
+        if ((replay_ || rewinding_) && (event == LEFT || event == RIGHT || event == UP || event == STILL))
+            continue; // during playback, the recording drives the player, and while rewinding, the history does
+        if (recorder_) {
+            if (const auto rev = toReplayEvent(event))
+                recorder_->add(sim_->tick(), *rev);
+        }
         switch (event) {
         case LEFT:
-            player_->move(-1);
+            applyInput(Simulation::Input::Left);
             break;
         case RIGHT:
-            player_->move(1);
+            applyInput(Simulation::Input::Right);
             break;
         case STILL:
-            player_->move(0);
+            applyInput(Simulation::Input::Still);
             break;
         case UP:
-            if (player_->jump())
+            if (applyInput(Simulation::Input::Up))
                 audio_->playJetpackSound(); // only play sound if jumping did occur
             break;
         case PAUSEPLAY:
@@ -247,6 +464,12 @@ bool Game::handlePlayerInput()
         case FPS_TOGGLE:
             show_fps_ = !show_fps_;
             break;
+        case TRACE_DUMP:
+            if constexpr (Profiler::Enabled)
+                dumpTrace();
+            else
+                Warning("Profiling is not compiled in (configure with -DJUMPMAN_PROFILE=ON)");
+            break;
         default:
             break;
         }
@@ -254,109 +477,72 @@ bool Game::handlePlayerInput()
     return false;
 }
 
+bool Game::applyInput(Simulation::Input input)
+{
+    if (rewind_)
+        rewind_->input(sim_->tick(), input);
+    return sim_->handleInput(input);
+}
+
 int Game::letObjectsInteract(double dt)
 {
-    // takeAction handles gravity
-    player_->takeAction(dt);
-    for (auto & star : star_list_)
-        star->takeAction(dt);
-
-    /* Remove stars if the player touches them or they disappear off screen */
-    for (auto it = star_list_.begin(); it != star_list_.end();)
-        if (bool touches = player_->touches(it->get()); touches || (*it)->y() < 0) {
-            if (touches) {
-                bool const moving_star = bool(dynamic_cast<MovingStar *>(it->get()));
-                bool const ok = player_->jump(1 + moving_star);
-                if (ok && audio_->lastPlayedJetpackSoundAgeMS() > JETPACK_SOUND_DURATION_MS)
-                    audio_->playJetpackSound();
-                audio_->playStarSound();
-                if (moving_star) audio_->playStarSound(true);
-            }
-            it = star_list_.erase(it);
-        } else
-            ++it;
-
-    /* Add stars if there is room */
-    addStars();
-
-    /* If player falls below the screen - return game over */
-    if (player_->y() < -player_->height() * 2)
-        return 1;
-
-    /* If player is above the middle of the screen,
-     * lower everything to center the player */
-    const int offset_y = player_->y() - graphics_->screen_height() / 2;
-    if (offset_y > 0) {
-        player_->modifyY(-offset_y);
-        for (auto &star : star_list_)
-            star->modifyY(-offset_y);
-    }
-    return 0;
+    Simulation::Events events;
+    const int ret = sim_->letObjectsInteract(dt, &events);
+
+    if (events.star_jumped && audio_->lastPlayedJetpackSoundAgeMS() > JETPACK_SOUND_DURATION_MS)
+        audio_->playJetpackSound();
+    for (std::size_t kind = 0; kind < NUM_STAR_KINDS; ++kind)
+        for (unsigned sound = 0; sound < NUM_STAR_SOUNDS; ++sound)
+            if (STAR_BEHAVIOURS[kind].sounds & (1u << sound))
+                for (unsigned i = 0; i < events.stars_touched[kind]; ++i)
+                    audio_->playStarSound(sound);
+
+    return ret;
 }
 
-void Game::drawObjectsToScreen()
+void Game::drawObjectsToScreen(double alpha)
 {
+    PROFILE_ZONE("drawObjectsToScreen");
     rect_t draw_to;
     rect_t draw_from;
+    const Player &player = sim_->player();
+    // world y - camera_y = screen y
+    const double camera_y = sim_->lerpCameraY(alpha);
 
     /* Draw background black */
     graphics_->makeScreenBlack();
 
     /* Draw all stars */
-    for (auto &star : star_list_) {
-        draw_to = {star->x(), star->y(), star->width(), star->height()};
-        draw_from = {star->imageX(), 0, draw_to.w, draw_to.h};
-        graphics_->drawImage(star->filename(), &draw_from, &draw_to);
-    }
+    sim_->stars().forEach([&](const StarPool::Star &star) {
+        const StarBehaviour &b = behaviour(star.kind);
+        draw_to = {int(star.lerpX(alpha)), int(star.lerpY(alpha) - camera_y), b.width, b.height};
+        draw_from = {star.imageX(), 0, draw_to.w, draw_to.h};
+        graphics_->queueImage(star_images_[std::size_t(star.kind)], draw_from, draw_to);
+    });
 
     /* Draw player */
-    draw_to = {player_->x(), player_->y(), player_->width(), player_->height()};
-    draw_from = {player_->imageX(), player_->imageY(), player_->width(), player_->height()};
-    graphics_->drawImage(player_->filename(), &draw_from, &draw_to);
+    draw_to = {int(player.lerpX(alpha)), int(player.lerpY(alpha) - camera_y), player.width(), player.height()};
+    draw_from = {player.imageX(), player.imageY(), player.width(), player.height()};
+    graphics_->queueImage(player.image(), draw_from, draw_to);
 
     /* Draw score */
-    const std::string score_string = "Score: " + std::to_string(player_->score());
-    graphics_->drawText(score_string, 20);
+    graphics_->drawText(hud_.score(player.score()), 20);
 
-    const std::string velocity_string = "Velocity: " + std::to_string(int(std::round(player_->velocity()))) + " m/s ";
-    graphics_->drawText(velocity_string, 20, WHITE, AlignRight, true);
+    graphics_->drawText(hud_.velocity(player.velocity()), 20, WHITE, AlignRight, true);
 
     /* Draw instructions after 5 seconds of no jumps */
-    if (player_->isStandingOnFloor() && SDL_GetTicks() - start_ticks_ > 5000) {
+    if (player.isStandingOnFloor() && SDL_GetTicks() - start_ticks_ > 5000) {
         graphics_->drawText("UP to jump",
                             graphics_->screen_height() + 440, CYAN, AlignCenter);
     }
 
     /* Draw FPS */
     if (show_fps_) {
-        graphics_->drawText(" FPS: " + std::to_string(int(std::round(fps_))),
+        graphics_->drawText(hud_.frameStats(shown_frame_stats_, pacer_.lastLatenessMS()),
                             graphics_->screen_height()*2 - 20,  GREEN, AlignLeft, true, true);
     }
 }
 
-void Game::addStars()
-{
-    const signed screen_height = static_cast<signed>(graphics_->screen_height());
-    const signed half_screen_width = graphics_->screen_width() / 2;
-
-    /* Make sure there's always at least one star in the starlist
-     * This is just to avoid segfaults */
-    if (star_list_.size() <= 0)
-        star_list_.emplace_back(new BasicStar(0, half_screen_width));
-
-    /* Make sure there's a BasicStar every 50 y-pixels,
-     * Also add other types of stars if the RNG is with you */
-    auto rgen = GetRandGen(0, 6);
-    while (star_list_.back()->initialY() < screen_height) {
-        const short last_y = star_list_.back()->initialY();
-
-        star_list_.emplace_back(new BasicStar(last_y, half_screen_width));
-
-        if (rgen() == 1)
-            star_list_.emplace_back(new MovingStar(last_y, half_screen_width));
-    }
-}
-
 auto Game::drawGameOverScreen() -> RunStepResult
 {
     assert(bool(game_over));
@@ -369,7 +555,7 @@ auto Game::drawGameOverScreen() -> RunStepResult
     std::string & nick = game_over->nick;
 
     if (state == ST::Begin) {
-        if (highscore.add(player_->score(), &new_idx)) {
+        if (!rewound_ && highscore.add(sim_->player().score(), &new_idx)) {
             // new high score
             state = ST::InputHS;
         } else {
@@ -387,7 +573,8 @@ auto Game::drawGameOverScreen() -> RunStepResult
     bool want_highlight = state == ST::InputHS;
     for (size_t i = 0, y = 300; i < game_over->highscore.size(); ++i) {
         text_color_t text_color = YELLOW;
-        auto [score, name] = highscore.get(i);
+        const auto &[score, saved_name] = highscore.get(i);
+        const std::string *name = &saved_name;
 
         /* If we managed to get into the highscore, write the score in orange */
         if (want_highlight && i == new_idx) {
@@ -395,12 +582,10 @@ auto Game::drawGameOverScreen() -> RunStepResult
             want_highlight = false;
             graphics_->drawText("New highscore!", screen_height + 150);
             if (!nick.empty())
-                name = nick; // overwrite with current user inputted nickname in high scores
+                name = &nick; // overwrite with current user inputted nickname in high scores
         }
-        if (score != 0 && !name.empty()) {
-            if (name.size() < 5) name.resize(5, ' ');
-            const std::string text = strprintf("%s  %7i", name, score);
-            graphics_->drawText(text, y, text_color);
+        if (score != 0 && !name->empty()) {
+            graphics_->drawText(hud_.highscoreRow(i, *name, score), y, text_color);
             y += 40;
         }
     }
@@ -408,7 +593,7 @@ auto Game::drawGameOverScreen() -> RunStepResult
     if (state == ST::InputHS) {
         /* If we managed to get into the highscore: Ask for nickname */
         graphics_->drawText("Enter your name (1-5 letters) and press enter", screen_height + 200);
-        graphics_->drawText(nick.empty() ? " " : nick, screen_height + 250, ORANGE);
+        graphics_->drawText(nick.empty() ? std::string_view(" ") : std::string_view(nick), screen_height + 250, ORANGE);
     } else if (state == ST::PressAnyKey) {
         /* Draw message that tells player that the game is over */
         graphics_->drawText("Press any key to continue", screen_height + 440);
@@ -431,6 +616,8 @@ auto Game::drawGameOverScreen() -> RunStepResult
             else if (key == SDLK_BACKSPACE && !nick.empty())
                 nick.resize(nick.size() - 1);
         } else if (state == ST::PressAnyKey) {
+            if (key == SDLK_r && rewind_)
+                continue; // 'r' rewinds rather than restarts
             // they pressed a key, indicate restart
             return R::Restart;
         }
@@ -489,6 +676,9 @@ auto Game::getEvent() const -> std::optional<event_t>
         case SDLK_f:
             ret = FPS_TOGGLE;
             break;
+        case SDLK_t:
+            ret = TRACE_DUMP;
+            break;
         default:
             ret = NOTHING;
             break;
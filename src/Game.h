@@ -11,18 +11,39 @@
 #pragma once
 
 #include "Common.h"
-#include "Player.h"
-
-#include <list>
+#include "FixedTimestep.h"
+#include "FramePacer.h"
+#include "FrameTimeHistogram.h"
+#include "Hud.h"
+#include "Simulation.h"
+
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <optional>
-#include <random>
 #include <string>
 #include <utility>
 
 class AudioEngine;
-class BasicStar;
 class GraphicsEngine;
+class ReplayReader;
+class ReplayWriter;
+class Rewind;
+enum class ReplayEvent : std::uint8_t;
+enum class RenderBackend : std::uint8_t;
+
+/// Startup options for Game, typically parsed from the command-line in main()
+struct GameOptions {
+    unsigned frame_rate = DEFAULT_FRAME_RATE; ///< Desired frames per second (desktop only; the browser paces WASM)
+    bool vsync = false;                   ///< Let the display's vertical sync pace frames, if the graphics support it
+    RenderBackend render_backend{};       ///< How to draw; the default, RenderBackend::Surface, blits on the CPU
+    unsigned sim_rate = DEFAULT_SIM_RATE; ///< Simulation ticks per second (independent of the frame rate)
+    std::optional<std::uint64_t> seed;    ///< If set, every game uses this level seed, otherwise a random one
+    std::string record_file;              ///< If not empty, each game's inputs are recorded to this file
+    std::string replay_file;              ///< If not empty, play back this recording instead of taking player input
+    std::string frame_stats_file;         ///< Where to write frame time statistics (JSON) on exit; empty = stderr
+    std::string trace_file = "jumpman_trace.json"; ///< Where 't' (and exit) write the profiler trace, if enabled
+};
 
 /*!
  * \class Game
@@ -36,8 +57,10 @@ class GraphicsEngine;
 class Game
 {
 public:
+    using Options = GameOptions;
+
     /// Constructor
-    Game();
+    Game(const Options &options = {});
 
     /// Disabled copy constructor
     Game(const Game &) = delete;
@@ -54,18 +77,23 @@ public:
      */
     int run();
 
+    /// Save the game's state: the simulation's (see Simulation::save()) plus whether the game is paused
+    void saveState(Snapshot &out) const;
+
+    /*!
+     * \brief Go back to a state saved by saveState(), leaving the game over screen if it is showing
+     *
+     * Recording stops, as the recording can't describe a game that went back in time, and the rewind history
+     * starts again from the restored state. Not possible while playing back a replay, which can't be rewound.
+     * \return false if the state was not restored
+     */
+    bool restoreState(const Snapshot &in);
+
     /// Shows a simple SDL message box with errMsg and then quits the application
     [[noreturn]] static void FatalError(const std::string &errMsg, const std::string &title = "Fatal Error");
     /// Log a warning message to console
     static void Warning(const std::string &msg);
 
-    /// Get a random number in the range [from, to]
-    static int GetRand32(int from, int to) { return GetRandGen(from, to)(); }
-
-    class RandGen; ///< fwd decl; has operator()()
-    /// Get a random number generator for the range [from, to]
-    static RandGen GetRandGen(int from, int to);
-
 private:
     /// Instance for managing graphics
     std::unique_ptr<GraphicsEngine> graphics_{};
@@ -73,24 +101,61 @@ private:
     /// Instance for managing audio
     std::unique_ptr<AudioEngine> audio_{};
 
-    /// List of all flying objects that the player can hit
-    std::list<std::unique_ptr<BasicStar>> star_list_;
+    /// The game rules: player, stars and how they interact
+    std::unique_ptr<Simulation> sim_;
 
-    /// Player instance
-    std::unique_ptr<Player> player_;
+    /// The image of each StarKind, in StarKind order; the player's is kept by the Player
+    std::array<ImageId, NUM_STAR_KINDS> star_images_{};
+
+    /// If set, the seed passed to sim_ on every reset(); otherwise each game gets a fresh random seed
+    const std::optional<std::uint64_t> fixed_seed_;
+
+    /// If not empty, the file each game's inputs are recorded to
+    const std::string record_file_;
+
+    /// Records the current game's inputs; only valid if record_file_ is not empty
+    std::unique_ptr<ReplayWriter> recorder_;
+
+    /// The recording being played back, if any
+    std::unique_ptr<ReplayReader> replay_;
+
+    /// The last few seconds of the current game, which holding 'r' plays backwards; null during replay playback
+    std::unique_ptr<Rewind> rewind_;
+
+    /// True while 'r' is held and the game is going backwards
+    bool rewinding_ = false;
+
+    /// True if the current game has been rewound; such a game doesn't go into the high scores
+    bool rewound_ = false;
 
     /// The last time the game was started
     unsigned start_ticks_{};
 
-    /// The tick count the last time runStep() was called
-    unsigned ticks_last_{};
+    /// Paces the main loop and measures how long each frame took
+    FramePacer pacer_;
+
+    /// Frame times for the whole session; dumped as JSON on exit
+    FrameTimeHistogram frame_stats_;
+
+    /// Frame times since recent_frame_stats_start_; rotated into shown_frame_stats_ every second
+    FrameTimeHistogram recent_frame_stats_, shown_frame_stats_;
+    unsigned recent_frame_stats_start_{};
+
+    /// Where frame_stats_ is written on exit
+    const std::string frame_stats_file_;
 
-    /// The current FPS
-    double fps_ = 0.;
+    /// Where the profiler's Chrome trace is written
+    const std::string trace_file_;
+
+    /// Hands out fixed-size simulation ticks from the variable wall-clock frame time
+    FixedTimestep timestep_;
 
     /// If 'f' is pressed, this becomes true
     bool show_fps_ = false;
 
+    /// The text drawn over the game and on the game over screen
+    Hud hud_;
+
     /// If true game is paused
     bool paused_ = false;
 
@@ -103,6 +168,39 @@ private:
     /// Reset the game to start state
     void reset();
 
+    /// Adds a frame time to the frame time statistics
+    void recordFrameTime(double frame_ms);
+
+    /// Writes frame_stats_ as JSON to frame_stats_file_ (or stderr)
+    void dumpFrameStats() const;
+
+    /// Writes the profiler's zones to trace_file_ (only does something if profiling is compiled in)
+    void dumpTrace() const;
+
+    /// Feeds sim_ all inputs from replay_ that are due before the next tick
+    void applyReplayInputs();
+
+    /// Hands input to sim_, noting it in the rewind history. \return what Simulation::handleInput() returned
+    bool applyInput(Simulation::Input input);
+
+    /// \return true if the game should go backwards this frame: 'r' is held and rewinding is possible
+    bool wantsRewind() const;
+
+    /// Take the game back by up to ticks ticks
+    void rewind(unsigned ticks);
+
+    /// After a rewind, in which arrow key events were ignored, move the player the way the arrow keys held now say
+    void followHeldKeys();
+
+    /// Catch up with sim_ having gone back in time: stop recording, and leave the game over screen if need be
+    void wentBackInTime();
+
+    /*!
+     * \brief Called when the player has died
+     * \return true if the game should go to the game over screen, false if it should quit (end of replay)
+     */
+    bool onPlayerDied();
+
     /*!
      * \enum event_t
      * \brief events describing user input
@@ -115,7 +213,8 @@ private:
         PAUSEPLAY, /*!< Player wants to pause/play music */
         NOTHING,   /*!< Unknown input received */
         QUIT,      /*!< User wants to exit the game */
-        FPS_TOGGLE /*!< User hit F to toggle fps display */
+        FPS_TOGGLE, /*!< User hit F to toggle fps display */
+        TRACE_DUMP  /*!< User hit T to write the profiler trace */
     };
 
     /*!
@@ -133,6 +232,9 @@ private:
      */
     std::optional<std::pair<int, bool>> getKeyEvent() const;
 
+    /// \return the ReplayEvent to record for event, or nothing if event is not recorded
+    static std::optional<ReplayEvent> toReplayEvent(event_t event);
+
     /*!
      * \brief handles player input
      * \return true if user wants to quit the game, false otherwise
@@ -140,9 +242,7 @@ private:
     bool handlePlayerInput();
 
     /*!
-     * All action happens here
-     *
-     * \brief lets objects interact with each other
+     * \brief Advances the simulation by one tick and plays any sounds that result
      * \param dt - Time elapsed. This is on a timescale where 1.0 corresponds to 41.6667 msec (24 FPS)
      * \return 1 if player has died
      */
@@ -150,12 +250,10 @@ private:
 
     /*!
      * \brief draw updates to screen, does not update SDL window (caller must do that)
-     * \return false on graphics failure, true on success
+     * \param alpha how far we are between the previous and the current simulation tick; sprite positions are
+     *        interpolated accordingly
      */
-    void drawObjectsToScreen();
-
-    /// Add stars to star_list_ until they fill up the screen
-    void addStars();
+    void drawObjectsToScreen(double alpha = 1.0);
 
     struct GameOver;
     std::unique_ptr<GameOver> game_over;
@@ -168,14 +266,4 @@ private:
 
     /// Only used on iOS
     mutable event_t lastMouseDir = NOTHING;
-
-public:
-    class RandGen {
-        friend class Game;
-        std::mt19937 &gen;
-        std::uniform_int_distribution<int> dist;
-        RandGen(std::mt19937 &g, int from, int to) : gen(g), dist(from, to) {}
-    public:
-        int operator()() { return dist(gen); }
-    };
 };
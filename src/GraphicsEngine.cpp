@@ -10,40 +10,103 @@
  */
 #include "GraphicsEngine.h"
 #include "Game.h"
+#include "Profiler.h"
 
 #include <SDL.h>
 #include <SDL_image.h>
 
 #include <algorithm>
+#include <utility>
 
-GraphicsEngine::GraphicsEngine(const std::string &title, const unsigned screen_width, const unsigned screen_height)
-    : TITLE(title), SCREEN_WIDTH(screen_width), SCREEN_HEIGHT(screen_height)
+inline constexpr int ATLAS_WIDTH = 1024; /* the atlas is this wide, or as wide as the widest image if that is wider */
+inline constexpr int ATLAS_PADDING = 1;  /* pixels between images in the atlas, so that filtering can't bleed */
+
+namespace {
+/// \return src (all of the image if nullptr), clipped to the image, in the coordinates of the atlas it is in at image
+SDL_Rect atlasRect(const SDL_Rect &image, const SDL_Rect *src)
 {
-    /* Init SDL*/
-    if (SDL_Init(SDL_INIT_VIDEO) == -1)
-        Game::FatalError(SDL_GetError(), "Failed to Initialize SDL");
+    if (!src)
+        return image;
+    const int x0 = std::clamp(src->x, 0, image.w), y0 = std::clamp(src->y, 0, image.h);
+    const int x1 = std::clamp(src->x + src->w, x0, image.w), y1 = std::clamp(src->y + src->h, y0, image.h);
+    return {image.x + x0, image.y + y0, x1 - x0, y1 - y0};
+}
 
-    /* Create a main screen */
-    win = SDL_CreateWindow(TITLE.c_str(), SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH, SCREEN_HEIGHT,
-                           SDL_WINDOW_SHOWN | SDL_WINDOW_INPUT_FOCUS);
-    if (!win)
-        Game::FatalError(SDL_GetError(), "Failed to Create Window");
+/*!
+ * \brief Shelf packing: tallest first, left to right, in rows as tall as the first rect in them
+ * \param rects the rects to pack; their w and h are read, and their x and y set
+ * \return the width and height of the atlas they fit in
+ */
+std::pair<int, int> shelfPack(std::vector<SDL_Rect *> rects)
+{
+    int width = ATLAS_WIDTH;
+    for (const SDL_Rect *r : rects)
+        width = std::max(width, r->w);
+    std::stable_sort(rects.begin(), rects.end(), [](const SDL_Rect *a, const SDL_Rect *b) { return a->h > b->h; });
+    int x = 0, y = 0, row_height = 0;
+    for (SDL_Rect *r : rects) {
+        if (x + r->w > width) {
+            x = 0;
+            y += row_height + ATLAS_PADDING;
+            row_height = 0;
+        }
+        r->x = x;
+        r->y = y;
+        x += r->w + ATLAS_PADDING;
+        row_height = std::max(row_height, r->h);
+    }
+    return {width, std::max(y + row_height, 1)};
+}
+} // namespace
 
-    screen_ = SDL_GetWindowSurface(win);
-    if (!screen_)
-        Game::FatalError(SDL_GetError(), "Failed to Get SDL Surface");
+GraphicsEngine::GraphicsEngine(const std::string &title, const unsigned screen_width, const unsigned screen_height,
+                               Target target, RenderBackend backend)
+    : TITLE(title), SCREEN_WIDTH(screen_width), SCREEN_HEIGHT(screen_height)
+{
+    if (target == Target::Offscreen) {
+        /* Draw into a plain surface in RAM */
+        screen_ = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+        if (!screen_)
+            Game::FatalError(SDL_GetError(), "Failed to Create Offscreen Surface");
+        if (backend != RenderBackend::Surface && !(renderer_ = SDL_CreateSoftwareRenderer(screen_)))
+            Game::FatalError(SDL_GetError(), "Failed to Create Renderer");
+    } else {
+        /* Init SDL*/
+        if (SDL_Init(SDL_INIT_VIDEO) == -1)
+            Game::FatalError(SDL_GetError(), "Failed to Initialize SDL");
+
+        /* Create a main screen */
+        win = SDL_CreateWindow(TITLE.c_str(), SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, SCREEN_WIDTH,
+                               SCREEN_HEIGHT, SDL_WINDOW_SHOWN | SDL_WINDOW_INPUT_FOCUS);
+        if (!win)
+            Game::FatalError(SDL_GetError(), "Failed to Create Window");
+
+        if (backend == RenderBackend::Surface) {
+            screen_ = SDL_GetWindowSurface(win);
+            if (!screen_)
+                Game::FatalError(SDL_GetError(), "Failed to Get SDL Surface");
+        } else {
+            /* Without flags SDL picks the first driver that works, trying the accelerated ones first */
+            const Uint32 flags = backend == RenderBackend::SoftwareRenderer ? SDL_RENDERER_SOFTWARE : 0;
+            renderer_ = SDL_CreateRenderer(win, -1, flags);
+            if (!renderer_)
+                Game::FatalError(SDL_GetError(), "Failed to Create Renderer");
+        }
+    }
 
     /* Init TTF */
     if (TTF_Init() == -1)
         Game::FatalError(TTF_GetError(), "Failed to Initialize TTF");
 
     /* Load font from disk */
-    font_ = TTF_OpenFont("graphics/font.ttf", 20);
-    if (font_ == nullptr)
+    font_.ttf = TTF_OpenFont("graphics/font.ttf", 20);
+    if (font_.ttf == nullptr)
         Game::FatalError(TTF_GetError(), "Failed to Load Font");
-    font_small_ = TTF_OpenFont("graphics/font.ttf", 14);
-    if (font_small_ == nullptr)
+    font_small_.ttf = TTF_OpenFont("graphics/font.ttf", 14);
+    if (font_small_.ttf == nullptr)
         Game::FatalError(TTF_GetError(), "Failed to Load Font");
+    if (!rasterizeFonts())
+        Game::FatalError(TTF_GetError(), "Failed to Rasterize Font");
 
     /* Initialize timer */
     if (SDL_InitSubSystem(SDL_INIT_TIMER) == -1)
@@ -53,86 +116,270 @@ GraphicsEngine::GraphicsEngine(const std::string &title, const unsigned screen_w
 GraphicsEngine::~GraphicsEngine()
 {
     /* Unload all images */
-    for (auto image : this->images_) {
-        SDL_FreeSurface(image.second);
-        image.second = nullptr;
-    }
+    for (Image &image : this->images_)
+        SDL_FreeSurface(image.surface);
+    SDL_FreeSurface(atlas_);
+    if (atlas_texture_)
+        SDL_DestroyTexture(atlas_texture_);
 
     /* Unload font */
-    TTF_CloseFont(font_);
-    TTF_CloseFont(font_small_);
+    SDL_FreeSurface(glyph_atlas_);
+    if (glyph_atlas_texture_)
+        SDL_DestroyTexture(glyph_atlas_texture_);
+    TTF_CloseFont(font_.ttf);
+    TTF_CloseFont(font_small_.ttf);
 
     TTF_Quit();
-    SDL_DestroyWindow(win);
-    // no need to free window surface
+    if (renderer_)
+        SDL_DestroyRenderer(renderer_);
+    if (win)
+        SDL_DestroyWindow(win); // no need to free window surface
+    else
+        SDL_FreeSurface(screen_); // offscreen surface is ours
     SDL_QuitSubSystem(SDL_INIT_TIMER);
     SDL_QuitSubSystem(SDL_INIT_VIDEO);
 }
 
-bool GraphicsEngine::loadImage(const std::string &filename)
+ImageId GraphicsEngine::loadImage(const std::string &filename)
 {
     /* Check if image is already loaded */
-    if (this->images_.count(filename))
-        return true;
+    if (const auto it = this->image_ids_.find(filename); it != this->image_ids_.end())
+        return it->second;
+    if (this->images_.size() >= NO_IMAGE)
+        return NO_IMAGE; // out of ids
 
     /* Load image from disk: */
     const std::string real_filename = "graphics/" + filename + ".png";
     SDL_Surface *scratch_surface = IMG_Load(real_filename.c_str());
     if (scratch_surface == nullptr)
-        return false;
+        return NO_IMAGE;
+
+    /* Give every image the atlas's format */
+    SDL_Surface *image = SDL_ConvertSurfaceFormat(scratch_surface, SDL_PIXELFORMAT_ARGB8888, 0);
+    SDL_FreeSurface(scratch_surface);
+    if (image == nullptr)
+        return NO_IMAGE;
 
     /* Set transparency (White is transparent); */
-    SDL_SetColorKey(scratch_surface, SDL_TRUE, SDL_MapRGB(scratch_surface->format, 255, 255, 255));
+    SDL_SetColorKey(image, SDL_TRUE, SDL_MapRGB(image->format, 255, 255, 255));
+
+    /* Add it to list of images, and to the atlas */
+    this->images_.push_back({image, {}});
+    if (!packAtlas()) {
+        this->images_.pop_back();
+        SDL_FreeSurface(image);
+        return NO_IMAGE;
+    }
+    const ImageId id = ImageId(this->images_.size() - 1);
+    this->image_ids_[filename] = id;
+    return id;
+}
 
-    /* Format image to optimize it */
-    SDL_Surface *optimized_image = SDL_ConvertSurface(scratch_surface, screen_->format, 0);
-    SDL_FreeSurface(scratch_surface);
-    if (optimized_image == nullptr)
+auto GraphicsEngine::findImage(ImageId image) const -> const Image *
+{
+    return image < this->images_.size() ? &this->images_[image] : nullptr;
+}
+
+bool GraphicsEngine::packAtlas()
+{
+    PROFILE_ZONE("packAtlas");
+    flushImages(); // the queue is in the current atlas's coordinates
+
+    std::vector<SDL_Rect *> rects;
+    for (Image &image : this->images_) {
+        image.rect = {0, 0, image.surface->w, image.surface->h};
+        rects.push_back(&image.rect);
+    }
+    const auto [width, height] = shelfPack(std::move(rects));
+
+    /* Copy the images in, on a white (so transparent) background */
+    SDL_Surface *atlas = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    if (atlas == nullptr)
+        return false;
+    const Uint32 white = SDL_MapRGB(atlas->format, 255, 255, 255);
+    SDL_FillRect(atlas, nullptr, white);
+    for (const Image &image : this->images_) {
+        SDL_Rect to = image.rect;
+        SDL_BlitSurface(image.surface, nullptr, atlas, &to);
+    }
+    SDL_SetColorKey(atlas, SDL_TRUE, white);
+
+    if (renderer_) {
+        /* The color key becomes the texture's alpha channel */
+        SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer_, atlas);
+        SDL_FreeSurface(atlas);
+        if (texture == nullptr)
+            return false;
+        if (atlas_texture_)
+            SDL_DestroyTexture(atlas_texture_);
+        atlas_texture_ = texture;
+    } else {
+        /* Format atlas to optimize it */
+        SDL_Surface *optimized_atlas = SDL_ConvertSurface(atlas, screen_->format, 0);
+        SDL_FreeSurface(atlas);
+        if (optimized_atlas == nullptr)
+            return false;
+        SDL_FreeSurface(atlas_);
+        atlas_ = optimized_atlas;
+    }
+    atlas_width_ = width;
+    atlas_height_ = height;
+    return true;
+}
+
+bool GraphicsEngine::rasterizeFonts()
+{
+    PROFILE_ZONE("rasterizeFonts");
+
+    /* Render and measure every glyph of every font */
+    std::vector<std::pair<SDL_Surface *, SDL_Rect *>> rendered;
+    std::vector<SDL_Rect *> rects;
+    for (Font *font : {&font_, &font_small_}) {
+        font->height = TTF_FontHeight(font->ttf);
+        for (int g = 0; g < NUM_GLYPHS; ++g) {
+            const Uint16 ch = Uint16(FIRST_GLYPH + g);
+            Glyph &glyph = font->glyphs[g];
+            int minx = 0, maxx = 0, miny = 0, maxy = 0;
+            TTF_GlyphMetrics(font->ttf, ch, &minx, &maxx, &miny, &maxy, &glyph.advance);
+            glyph.x_offset = std::min(minx, 0);
+            for (int next = 0; next < NUM_GLYPHS; ++next)
+                font->kerning[g * NUM_GLYPHS + next] =
+                    std::int8_t(TTF_GetFontKerningSizeGlyphs(font->ttf, ch, Uint16(FIRST_GLYPH + next)));
+            // a glyph without pixels, like a space, may not render at all; it is only an advance then
+            if (SDL_Surface *surface = TTF_RenderGlyph_Blended(font->ttf, ch, {255, 255, 255, 255})) {
+                glyph.rect = {0, 0, surface->w, surface->h};
+                rendered.emplace_back(surface, &glyph.rect);
+                rects.push_back(&glyph.rect);
+            }
+        }
+    }
+    const auto [width, height] = shelfPack(std::move(rects));
+
+    /* Copy the glyphs in, alpha and all, on a transparent background */
+    SDL_Surface *atlas = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32, SDL_PIXELFORMAT_ARGB8888);
+    for (const auto &[surface, rect] : rendered) {
+        if (atlas) {
+            SDL_Rect to = *rect;
+            SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+            SDL_BlitSurface(surface, nullptr, atlas, &to);
+        }
+        SDL_FreeSurface(surface);
+    }
+    if (atlas == nullptr)
         return false;
+    SDL_SetSurfaceBlendMode(atlas, SDL_BLENDMODE_BLEND);
 
-    /* Add it to list of images */
-    this->images_[filename] = optimized_image;
+    if (renderer_) {
+        glyph_atlas_texture_ = SDL_CreateTextureFromSurface(renderer_, atlas);
+        SDL_FreeSurface(atlas);
+        if (glyph_atlas_texture_ == nullptr)
+            return false;
+        SDL_SetTextureBlendMode(glyph_atlas_texture_, SDL_BLENDMODE_BLEND);
+    } else
+        glyph_atlas_ = atlas; // not converted: the screen's format has no alpha channel
+    glyph_atlas_width_ = width;
+    glyph_atlas_height_ = height;
     return true;
 }
 
 std::string GraphicsEngine::getLastError() const { return SDL_GetError(); }
 
-void GraphicsEngine::makeScreenBlack() { SDL_FillRect(this->screen_, nullptr, 0); }
+void GraphicsEngine::makeScreenBlack()
+{
+    queue_.clear(); // it would be painted over anyway
+    if (renderer_) {
+        SDL_SetRenderDrawColor(renderer_, 0, 0, 0, 255);
+        SDL_RenderClear(renderer_);
+    } else
+        SDL_FillRect(this->screen_, nullptr, 0);
+}
 
-bool GraphicsEngine::drawImage(const std::string &filename, rect_t *srcrect, rect_t *dstrect)
+bool GraphicsEngine::drawImage(ImageId image, rect_t *srcrect, rect_t *dstrect)
 {
-    /* First, check if the image is loaded */
-    SDL_Surface *image_to_blit = nullptr;
-    if (this->images_.count(filename))
-        image_to_blit = this->images_[filename];
+    const Image *image_to_blit = findImage(image);
+    if (image_to_blit == nullptr)
+        return false;
+    flushImages();
 
-    /* If image was not found, try to load it */
-    if (image_to_blit == nullptr) {
-        if (this->loadImage(filename) == false)
-            return false;
+    if (dstrect != nullptr)
+        toScreen(*dstrect);
+
+    /* Draw it */
+    const SDL_Rect from = atlasRect(image_to_blit->rect, srcrect);
+    if (renderer_)
+        SDL_RenderCopy(renderer_, atlas_texture_, &from, dstrect);
+    else
+        SDL_BlitSurface(atlas_, &from, this->screen_, dstrect);
+
+    return true;
+}
+
+bool GraphicsEngine::queueImage(ImageId image, const rect_t &srcrect, const rect_t &dstrect)
+{
+    const Image *image_to_queue = findImage(image);
+    if (image_to_queue == nullptr)
+        return false;
+    rect_t to = dstrect;
+    toScreen(to);
+    queue_.emplace_back(atlasRect(image_to_queue->rect, &srcrect), to);
+    return true;
+}
+
+void GraphicsEngine::flushImages()
+{
+    if (queue_.empty())
+        return;
+    PROFILE_ZONE("flushImages");
+    drawQuads(atlas_, atlas_texture_, atlas_width_, atlas_height_, queue_, {255, 255, 255, 255});
+    queue_.clear();
+}
 
-        image_to_blit = this->images_[filename];
+void GraphicsEngine::drawQuads(SDL_Surface *atlas, SDL_Texture *texture, int atlas_width, int atlas_height,
+                               const std::vector<std::pair<SDL_Rect, SDL_Rect>> &quads, SDL_Color color)
+{
+    if (!renderer_) {
+        SDL_SetSurfaceColorMod(atlas, color.r, color.g, color.b);
+        for (const auto &[from, to] : quads) {
+            SDL_Rect clipped_to = to; // SDL_BlitSurface() writes the clipped rectangle back
+            SDL_BlitSurface(atlas, &from, this->screen_, &clipped_to);
+        }
+        return;
     }
 
+    /* Two triangles per quad, all from the one atlas texture, so all in one call */
+    const float u_scale = 1.0f / atlas_width, v_scale = 1.0f / atlas_height;
+    vertices_.clear();
+    for (const auto &[from, to] : quads) {
+        const float x0 = to.x, y0 = to.y, x1 = to.x + to.w, y1 = to.y + to.h;
+        const float u0 = from.x * u_scale, v0 = from.y * v_scale;
+        const float u1 = (from.x + from.w) * u_scale, v1 = (from.y + from.h) * v_scale;
+        vertices_.push_back({{x0, y0}, color, {u0, v0}});
+        vertices_.push_back({{x1, y0}, color, {u1, v0}});
+        vertices_.push_back({{x0, y1}, color, {u0, v1}});
+        vertices_.push_back({{x1, y1}, color, {u1, v1}});
+    }
+    // the indices are the same every time, so only the ones for quads beyond the most ever drawn get added
+    for (int i = int(indices_.size() / 6 * 4); indices_.size() < quads.size() * 6; i += 4)
+        indices_.insert(indices_.end(), {i, i + 1, i + 2, i + 2, i + 1, i + 3});
+    SDL_RenderGeometry(renderer_, texture, vertices_.data(), int(vertices_.size()), indices_.data(),
+                       int(quads.size() * 6));
+}
+
+void GraphicsEngine::toScreen(rect_t &r) const
+{
     /* Doing some switcheroo here,
      * X:0 is now at the center of the screen
      * Y:0 is not at the bottom of the screen */
-    if (dstrect != nullptr) {
-        dstrect->x = SCREEN_WIDTH / 2 - dstrect->w / 2 + dstrect->x;
-        dstrect->y = SCREEN_HEIGHT - dstrect->h - dstrect->y;
-    }
-
-    /* Draw it */
-    SDL_BlitSurface(image_to_blit, srcrect, this->screen_, dstrect);
-
-    return true;
+    r.x = SCREEN_WIDTH / 2 - r.w / 2 + r.x;
+    r.y = SCREEN_HEIGHT - r.h - r.y;
 }
 
-void GraphicsEngine::drawText(const std::string &text, unsigned y, text_color_t text_color_name, alignment_t align,
+void GraphicsEngine::drawText(std::string_view text, unsigned y, text_color_t text_color_name, alignment_t align,
                               bool small, bool bright)
 {
+    PROFILE_ZONE("drawText");
+    flushImages();
     SDL_Color text_color;
-    const SDL_Color background_color = {0, 0, 0, 0};
 
     switch (text_color_name) {
     case RED: text_color = {127, 0, 0, 0}; break;
@@ -152,31 +399,66 @@ void GraphicsEngine::drawText(const std::string &text, unsigned y, text_color_t
         text_color.b = std::max(text_color.b * 2, 16);
     }
 
-    /* Craete text */
-    SDL_Surface *text_surface = TTF_RenderText_Shaded(small ? font_small_ :font_,
-                                                      text.c_str(), text_color, background_color);
-
-    /* Set transparency */
-    SDL_SetColorKey(text_surface, SDL_TRUE, SDL_MapRGB(text_surface->format, 0, 0, 0));
+    /* Lay the text out, glyph by glyph */
+    const Font &font = small ? font_small_ : font_;
+    text_quads_.clear();
+    int pen_x = 0, prev = -1;
+    for (const unsigned char c : text) {
+        const int g = (c >= FIRST_GLYPH && c <= LAST_GLYPH ? c : '?') - FIRST_GLYPH;
+        if (prev >= 0)
+            pen_x += font.kerning[prev * NUM_GLYPHS + g];
+        const Glyph &glyph = font.glyphs[g];
+        if (glyph.rect.w > 0)
+            text_quads_.emplace_back(glyph.rect, SDL_Rect{pen_x + glyph.x_offset, 0, glyph.rect.w, glyph.rect.h});
+        pen_x += glyph.advance;
+        prev = g;
+    }
 
     int pos_x{};
     switch (align) {
     case AlignLeft: pos_x = 0; break;
-    case AlignCenter: pos_x = SCREEN_WIDTH / 2 - text_surface->w / 2; break;
-    case AlignRight: pos_x = SCREEN_WIDTH - text_surface->w;
+    case AlignCenter: pos_x = SCREEN_WIDTH / 2 - pen_x / 2; break;
+    case AlignRight: pos_x = SCREEN_WIDTH - pen_x;
     }
+    const int pos_y = static_cast<int>(y) / 2 - font.height / 2;
 
-    /* Set target rect */
-    SDL_Rect dstrect{pos_x, static_cast<int>(y) / 2 - text_surface->h / 2, 0, 0};
-
-    /* Blit and release */
-    SDL_BlitSurface(text_surface, nullptr, this->screen_, &dstrect);
-    SDL_FreeSurface(text_surface);
+    /* Move it into place and draw it */
+    for (auto &[from, to] : text_quads_) {
+        to.x += pos_x;
+        to.y += pos_y;
+    }
+    text_color.a = 255;
+    drawQuads(glyph_atlas_, glyph_atlas_texture_, glyph_atlas_width_, glyph_atlas_height_, text_quads_, text_color);
 }
 
 bool GraphicsEngine::updateScreen()
 {
-    return SDL_UpdateWindowSurface(win) == 0;
+    PROFILE_ZONE("updateScreen");
+    flushImages();
+    if (renderer_) {
+        SDL_RenderPresent(renderer_); // offscreen, this just finishes drawing into screen_
+        return true;
+    }
+    return !win || SDL_UpdateWindowSurface(win) == 0;
+}
+
+bool GraphicsEngine::setVSync(bool enabled)
+{
+    if (!renderer_) {
+        vsync_ = false; // SDL_UpdateWindowSurface() has no notion of vsync
+        return !enabled;
+    }
+    if (SDL_RenderSetVSync(renderer_, enabled) == 0)
+        vsync_ = enabled;
+    return vsync_ == enabled;
+}
+
+std::string GraphicsEngine::backendName() const
+{
+    SDL_RendererInfo info;
+    if (renderer_ && SDL_GetRendererInfo(renderer_, &info) == 0)
+        return info.name;
+    return renderer_ ? "renderer" : "surface";
 }
 
 unsigned GraphicsEngine::screen_width() const { return this->SCREEN_WIDTH; }
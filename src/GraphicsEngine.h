@@ -10,11 +10,18 @@
  */
 #pragma once
 
+#include "Common.h"
+
 #include <SDL.h>
 #include <SDL_ttf.h>
 
+#include <array>
+#include <cstdint>
 #include <map>
 #include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 using rect_t = SDL_Rect;
 
@@ -36,6 +43,16 @@ enum text_color_t {
 
 enum alignment_t { AlignLeft, AlignRight, AlignCenter };
 
+/*!
+ * \enum RenderBackend
+ * \brief How GraphicsEngine draws
+ */
+enum class RenderBackend : std::uint8_t {
+    Surface,          /*!< SDL_BlitSurface() onto the window's surface, all on the CPU, then a copy of the whole window */
+    Renderer,         /*!< An SDL_Renderer: GPU-accelerated where SDL has a driver for it, on the CPU elsewhere */
+    SoftwareRenderer, /*!< An SDL_Renderer that always draws on the CPU */
+};
+
 /*!
  * \class GraphicsEngine
  * \brief Class for managing graphics and events
@@ -43,17 +60,31 @@ enum alignment_t { AlignLeft, AlignRight, AlignCenter };
  * GraphicsEngine handles all input from the user and
  * handles all drawing of images on the screen.
  * Only one GraphicsEngine can be active at one time
+ *
+ * Every image loaded is packed into one atlas, so that any number of sprites can be drawn from a single
+ * surface or texture: queueImage() collects them, and the renderer backends draw them all with one
+ * SDL_RenderGeometry() call. Text is drawn the same way, from a second atlas holding every glyph of
+ * both fonts.
  */
 class GraphicsEngine
 {
 public:
+    /// Where drawing ends up
+    enum class Target {
+        Window,    ///< a real window
+        Offscreen, ///< an in-memory surface; no window or video driver needed (benchmarks)
+    };
+
     /*!
      * \brief Contructor
      * \param title The title that will be seen on the titlebar
      * \param screen_width Size of game screen's width
      * \param screen_height Size of the game screen's height
+     * \param target Whether to draw to a window or to an offscreen surface
+     * \param backend How to draw. Offscreen, both renderer backends use SDL's software renderer on the surface.
      */
-    GraphicsEngine(const std::string &title, const unsigned screen_width, const unsigned screen_height);
+    GraphicsEngine(const std::string &title, const unsigned screen_width, const unsigned screen_height,
+                   Target target = Target::Window, RenderBackend backend = RenderBackend::Surface);
 
     /// Disabled copy constructor
     GraphicsEngine(const GraphicsEngine &) = delete;
@@ -65,12 +96,12 @@ public:
     void operator=(const GraphicsEngine &) = delete;
 
     /*!
-     * \brief Loads and image from the disk into the RAM
+     * \brief Loads and image from the disk into the RAM, and packs it into the atlas along with the others
      * \param filename  Name of the image file inside graphics/ folder
      (example: to load graphics/player.png, filename should be "player")
-     * \return true on success
+     * \return the image's id, to draw it with; the same one again if it is already loaded. NO_IMAGE on failure.
      */
-    bool loadImage(const std::string &filename);
+    ImageId loadImage(const std::string &filename);
 
     /*!
      * \brief returns a string describing last error that occurred
@@ -84,19 +115,34 @@ public:
 
     /*!
      * \brief Draw an image to the game screen
-     * \param image filename of image to draw
+     * \param image what loadImage() returned for the image to draw
      * \param srcrect rectangle of image to draw from
      * \param dstrect part to screen to draw to
      * \return true on success
      */
-    bool drawImage(const std::string &image, rect_t *srcrect, rect_t *dstrect);
+    bool drawImage(ImageId image, rect_t *srcrect, rect_t *dstrect);
+
+    /*!
+     * \brief Like drawImage(), but only queue the image up, to be drawn in one go with everything else queued
+     *
+     * The queue is drawn, in order, by flushImages(), which every other drawing call and updateScreen() call
+     * first; makeScreenBlack() just empties it.
+     * \return true on success
+     */
+    bool queueImage(ImageId image, const rect_t &srcrect, const rect_t &dstrect);
+
+    /// Draw everything queueImage() queued up
+    void flushImages();
 
     /*!
      * \brief Draw some text at the given location
+     *
+     * The text is laid out from the glyphs and metrics measured when the fonts were loaded, and drawn from the glyph
+     * atlas in the text's color, so nothing is rasterized. Characters outside of printable ASCII are drawn as '?'.
      * \param text text to draw
      * \param y the center on the y-axis where we will draw
      */
-    void drawText(const std::string &text, unsigned y, text_color_t = CYAN, alignment_t = AlignCenter,
+    void drawText(std::string_view text, unsigned y, text_color_t = CYAN, alignment_t = AlignCenter,
                   bool small = false, bool bright = false);
 
     /*!
@@ -105,6 +151,20 @@ public:
      */
     bool updateScreen();
 
+    /*!
+     * \brief Ask for updateScreen() to wait for the display's vertical sync
+     * \return true if presentation is now vsync-driven. The Surface backend presents with
+     *         SDL_UpdateWindowSurface(), which never waits for vsync, so with it this always returns false when
+     *         enabling; the renderer backends return false if the driver can't.
+     */
+    bool setVSync(bool enabled);
+
+    /// \return true if updateScreen() waits for the display's vertical sync
+    bool vsync() const { return vsync_; }
+
+    /// \return the name of the SDL_Renderer driver drawing (e.g. "opengl" or "software"), or "surface"
+    std::string backendName() const;
+
     /// Returns width of game screen
     unsigned screen_width() const;
 
@@ -121,13 +181,90 @@ private:
     /// Height of the game screen
     const unsigned SCREEN_HEIGHT;
 
-    /// Map of filename and image we have loaded from disk
-    std::map<std::string, SDL_Surface *> images_;
+    /// An image loaded from disk
+    struct Image {
+        SDL_Surface *surface{}; ///< as loaded, with white color-keyed; kept for packing the atlas again
+        SDL_Rect rect{};        ///< where the image is in the atlas
+    };
+
+    /// The images we have loaded from disk, indexed by ImageId
+    std::vector<Image> images_;
+
+    /// Map of filename and the id of the image loaded from it; only loadImage() looks in it
+    std::map<std::string, ImageId> image_ids_;
 
-    /// Font to use
-    TTF_Font *font_{}, *font_small_{};
+    /// Every image, packed together; white is transparent. Only the Surface backend keeps it, in screen_'s format.
+    SDL_Surface *atlas_{};
+
+    /// The atlas as a texture, for the renderer backends
+    SDL_Texture *atlas_texture_{};
+    int atlas_width_{}, atlas_height_{};
+
+    /// What queueImage() queued up: where in the atlas to draw from, and where on screen to draw to
+    std::vector<std::pair<SDL_Rect, SDL_Rect>> queue_;
+
+    /// Where drawQuads() puts its quads as triangles for SDL_RenderGeometry(); kept to save reallocating them
+    std::vector<SDL_Vertex> vertices_;
+    std::vector<int> indices_;
+
+    /// The characters there are glyphs for: printable ASCII
+    static constexpr int FIRST_GLYPH = ' ', LAST_GLYPH = '~', NUM_GLYPHS = LAST_GLYPH - FIRST_GLYPH + 1;
+
+    /// A character of a font, as rasterized into the glyph atlas
+    struct Glyph {
+        SDL_Rect rect{};  ///< where the glyph is in the glyph atlas; empty if it has no pixels
+        int x_offset{};   ///< where the glyph's left edge is relative to the pen, when it reaches left of it
+        int advance{};    ///< how far the pen moves on after the glyph
+    };
+
+    /// A font at one size, with everything drawText() needs to lay text out in it
+    struct Font {
+        TTF_Font *ttf{};
+        int height{};
+        std::array<Glyph, NUM_GLYPHS> glyphs{};
+        std::array<std::int8_t, NUM_GLYPHS * NUM_GLYPHS> kerning{}; ///< [a * NUM_GLYPHS + b]: glyph a followed by b
+    };
+
+    /// Fonts to use
+    Font font_, font_small_;
+
+    /// Every glyph of every font, white on transparent; drawn with the text's color modulated in
+    SDL_Surface *glyph_atlas_{};
+    SDL_Texture *glyph_atlas_texture_{};
+    int glyph_atlas_width_{}, glyph_atlas_height_{};
+
+    /// The glyphs of the text drawText() is drawing, as queue_ has images; kept to save reallocating it
+    std::vector<std::pair<SDL_Rect, SDL_Rect>> text_quads_;
+
+    /// \return the image with id image, or nullptr if there is none
+    const Image *findImage(ImageId image) const;
+
+    /// Pack every image into the atlas again. \return true on success
+    bool packAtlas();
+
+    /// Rasterize the glyphs of font_ and font_small_ into the glyph atlas, and measure them. \return true on success
+    bool rasterizeFonts();
+
+    /*!
+     * \brief Draw quads (where in the atlas to draw from, and where on screen to draw to) from an atlas
+     * \param atlas the atlas, for the Surface backend
+     * \param texture the atlas, for the renderer backends
+     * \param color multiplies the atlas's colors
+     */
+    void drawQuads(SDL_Surface *atlas, SDL_Texture *texture, int atlas_width, int atlas_height,
+                   const std::vector<std::pair<SDL_Rect, SDL_Rect>> &quads, SDL_Color color);
+
+    /*!
+     * Move r from game coordinates, where x = 0 is the center of the screen and y = 0 is its bottom edge, to
+     * screen coordinates
+     */
+    void toScreen(rect_t &r) const;
 
     /// The game screen
     SDL_Window *win{};
-    SDL_Surface *screen_{}; // the window's surface
+    SDL_Surface *screen_{}; // the window's surface (Surface backend), or our own if win is nullptr (offscreen)
+    SDL_Renderer *renderer_{}; // draws to win, or to screen_ if offscreen; nullptr for the Surface backend
+
+    /// True if updateScreen() waits for vsync
+    bool vsync_ = false;
 };
@@ -40,12 +40,10 @@ void Highscore::save() const
     }
     if (on_save_cb) on_save_cb();
 }
-std::pair<size_t, std::string> Highscore::get(unsigned n) const
+const std::pair<size_t, std::string> &Highscore::get(unsigned n) const
 {
-    std::pair<size_t, std::string> ret;
-    if (n < highscore_.size())
-        ret = highscore_[n];
-    return ret;
+    static const std::pair<size_t, std::string> none;
+    return n < highscore_.size() ? highscore_[n] : none;
 }
 
 bool Highscore::add(size_t new_score, size_t *new_idx)
@@ -26,6 +26,9 @@
 class Highscore
 {
 public:
+    /// Number of scores kept
+    static constexpr size_t ROWS = 10;
+
     /// Constructor
     Highscore(const std::string &filename, const std::function<void()> & on_save_callback = {});
 
@@ -41,9 +44,9 @@ public:
     /*!
      * Returns the score at the nth position
      * \param n the score's position, top scorer would be n:0
-     * \return The pair of score, playername
+     * \return The pair of score, playername; 0 and an empty name if there is no nth position
      */
-    std::pair<size_t, std::string> get(unsigned n) const;
+    const std::pair<size_t, std::string> &get(unsigned n) const;
 
     /*!
      * \brief Adds score to highscore if applicable
@@ -82,5 +85,5 @@ private:
 
     const std::string filename_;
     const std::function<void()> on_save_cb;
-    std::array<std::pair<size_t, std::string>, 10> highscore_;
+    std::array<std::pair<size_t, std::string>, ROWS> highscore_;
 };
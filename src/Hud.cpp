@@ -0,0 +1,46 @@
+/*!
+ * \file Hud.cpp
+ * \brief File containing the Hud class source code
+ *
+ * \copyright GNU Public License
+ */
+#include "Hud.h"
+
+#include <cmath>
+
+std::string_view Hud::score(std::size_t score)
+{
+    return score_.text([](auto &out, std::size_t s) { out << "Score: " << s; }, score);
+}
+
+std::string_view Hud::velocity(double velocity)
+{
+    return velocity_.text([](auto &out, int v) { out << "Velocity: " << v << " m/s "; }, int(std::round(velocity)));
+}
+
+std::string_view Hud::frameStats(const FrameTimeHistogram &stats, double lateness_ms)
+{
+    const auto format = [](auto &out, int fps, double p50, double p95, double p99, double max, std::uint64_t overruns,
+                           double late) {
+        out << " FPS: " << fps << "  frame ms p50 ";
+        out.fixed(p50, 1) << "  p95 ";
+        out.fixed(p95, 1) << "  p99 ";
+        out.fixed(p99, 1) << "  max ";
+        out.fixed(max, 1) << "  over: " << overruns << "  late: ";
+        out.fixed(late, 2);
+    };
+    return frame_stats_.text(format, int(std::round(stats.meanMS() > 0.0 ? 1000.0 / stats.meanMS() : 0.0)),
+                             stats.percentileMS(50), stats.percentileMS(95), stats.percentileMS(99), stats.maxMS(),
+                             stats.overruns(), lateness_ms);
+}
+
+std::string_view Hud::highscoreRow(std::size_t row, const std::string &name, std::size_t score)
+{
+    if (row >= rows_.size())
+        rows_.resize(row + 1);
+    return rows_[row].text([](auto &out, const std::string &n, std::size_t s) {
+        out << n;
+        out.padTo(5) << "  ";
+        out.right(s, 7);
+    }, name, score);
+}
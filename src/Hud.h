@@ -0,0 +1,49 @@
+/*!
+ * \file Hud.h
+ * \brief File containing the Hud class, the text drawn over the game
+ *
+ * \copyright GNU Public License
+ */
+#pragma once
+
+#include "FrameTimeHistogram.h"
+#include "HudText.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*!
+ * \class Hud
+ * \brief Formats the text Game draws over the play area and on the game over screen, without allocating
+ *
+ * Every item is a HudText, so it is only formatted again when what it shows changes. Game draws what these
+ * return every frame, and the frame_allocations test calls them the same way to check that nothing allocates.
+ * Each returned string_view is valid until the same item is asked for again.
+ */
+class Hud
+{
+public:
+    /// \param highscore_rows the number of rows in the high score table
+    explicit Hud(std::size_t highscore_rows) : rows_(highscore_rows) {}
+
+    /// \return "Score: <score>"
+    std::string_view score(std::size_t score);
+
+    /// \return "Velocity: <velocity, rounded> m/s "
+    std::string_view velocity(double velocity);
+
+    /// \return the FPS overlay: frame rate and percentiles from stats, and the frame pacer's lateness
+    std::string_view frameStats(const FrameTimeHistogram &stats, double lateness_ms);
+
+    /// \return row of the high score table: name padded to 5 columns, then score right-aligned in 7
+    std::string_view highscoreRow(std::size_t row, const std::string &name, std::size_t score);
+
+private:
+    HudText<32, std::size_t> score_;
+    HudText<32, int> velocity_;
+    HudText<128, int, double, double, double, double, std::uint64_t, double> frame_stats_;
+    std::vector<HudText<16, std::string, std::size_t>> rows_;
+};
@@ -0,0 +1,120 @@
+/*!
+ * \file HudText.h
+ * \brief File containing TextBuffer and HudText, for formatting the text drawn every frame without allocating
+ *
+ * \copyright GNU Public License
+ */
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+/*!
+ * \class TextBuffer
+ * \brief Up to N characters of text, formatted in place with std::to_chars
+ *
+ * Nothing is ever allocated; whatever doesn't fit in the N characters is dropped.
+ */
+template <std::size_t N>
+class TextBuffer
+{
+public:
+    /// \return the text so far
+    std::string_view view() const { return {buf_.data(), size_}; }
+
+    /// \return the number of characters so far
+    std::size_t size() const { return size_; }
+
+    /// Start again with no text
+    void clear() { size_ = 0; }
+
+    /// Append s
+    TextBuffer &operator<<(std::string_view s)
+    {
+        size_ += s.copy(buf_.data() + size_, N - size_);
+        return *this;
+    }
+
+    /// Append v in decimal, like printf's "%d"
+    template <typename T>
+        requires(std::is_integral_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, bool>)
+    TextBuffer &operator<<(T v)
+    {
+        return right(v, 0);
+    }
+
+    /// Append v in decimal, right-aligned in width columns, like printf's "%<width>d"
+    template <typename T>
+        requires(std::is_integral_v<T> && !std::is_same_v<T, char> && !std::is_same_v<T, bool>)
+    TextBuffer &right(T v, std::size_t width)
+    {
+        char digits[24]; // enough for any 64-bit integer and its sign
+        const char *end = std::to_chars(std::begin(digits), std::end(digits), v).ptr;
+        const std::string_view s(digits, std::size_t(end - digits));
+        padTo(size_ + (width > s.size() ? width - s.size() : 0));
+        return *this << s;
+    }
+
+    /// Append v with precision digits after the point, like printf's "%.<precision>f"; nothing if it doesn't fit
+    TextBuffer &fixed(double v, int precision)
+    {
+        const auto [end, ec] = std::to_chars(buf_.data() + size_, buf_.data() + N, v, std::chars_format::fixed,
+                                             precision);
+        if (ec == std::errc())
+            size_ = std::size_t(end - buf_.data());
+        return *this;
+    }
+
+    /// Append spaces until the text is column characters long
+    TextBuffer &padTo(std::size_t column)
+    {
+        column = std::min(column, N);
+        for (; size_ < column; ++size_)
+            buf_[size_] = ' ';
+        return *this;
+    }
+
+private:
+    std::array<char, N> buf_;
+    std::size_t size_ = 0;
+};
+
+/*!
+ * \class HudText
+ * \brief A text item on the HUD, made of values of types Ts, which is only formatted again when they change
+ *
+ * Keep one per item, across frames, and call text() every frame: it formats into a TextBuffer<N> the first time
+ * and whenever the values differ from the last call's, and otherwise hands back the text as it was.
+ */
+template <std::size_t N, typename... Ts>
+class HudText
+{
+public:
+    /*!
+     * \param format called as format(buffer, values...) to write the text into buffer, a cleared TextBuffer<N>
+     * \return the text for values; valid until the next call
+     */
+    template <typename F>
+    std::string_view text(F &&format, const Ts &...values)
+    {
+        if (!values_ || *values_ != std::tie(values...)) {
+            values_.emplace(values...);
+            buffer_.clear();
+            format(buffer_, values...);
+        }
+        return buffer_.view();
+    }
+
+    /// Forget the values, so that the next text() formats again
+    void reset() { values_.reset(); }
+
+private:
+    std::optional<std::tuple<Ts...>> values_;
+    TextBuffer<N> buffer_;
+};
@@ -9,13 +9,44 @@
 
 #include "Player.h"
 
-#include <SDL.h>
-
 #include <algorithm>
 #include <cmath>
+#include <limits>
+#include <utility>
 
 inline constexpr double SPEED_LIMIT = 80.0; ///< disallow vertical speed greater than this speed
 
+namespace {
+/// \return how much higher something is after t, from a vertical speed of dy, under a gravity of 1
+double heightAfter(double dy, double t) { return dy * t - t * t / 2.0; }
+
+/// \return how much height is gained while rising during those t
+double riseAfter(double dy, double t) { return heightAfter(dy, std::clamp(t, 0.0, std::max(dy, 0.0))); }
+
+/// \return the first t in [t0, t1] where |a * t^2 + b * t + c| < r, or where it crosses r or -r; infinity if none
+double firstTimeWithin(double a, double b, double c, double r, double t0, double t1)
+{
+    if (std::abs((a * t0 + b) * t0 + c) < r)
+        return t0;
+    double first = std::numeric_limits<double>::infinity();
+    auto consider = [&](double t) {
+        if (t >= t0 && t <= t1)
+            first = std::min(first, t);
+    };
+    for (const double level : {-r, r}) {
+        if (a == 0.0) {
+            if (b != 0.0)
+                consider((level - c) / b);
+        } else if (const double disc = b * b - 4.0 * a * (c - level); disc >= 0.0) {
+            const double root = std::sqrt(disc);
+            consider((-b - root) / (2.0 * a));
+            consider((-b + root) / (2.0 * a));
+        }
+    }
+    return first;
+}
+} // namespace
+
 Player::Player(unsigned sw)
     : Sprite("player", 0, 0, 20, 40, 1), screen_width(sw)
 {
@@ -31,43 +62,165 @@ void Player::reset()
     this->dx_ = 0.0;
     this->dy_ = 0.0;
     this->standing_on_floor_ = true;
-    this->score_ = 0;
     this->facing_direction_ = true;
-    last_jump_ticks_ = 0;
+    last_jump_ticks_ = 0.0;
+    climbed_ = 0.0;
+    seg_dy_ = 0.0;
+    seg_t_ = 0.0;
+    startSegment();
+    tick_dt_ = tick_dy_ = 0.0;
+    tick_ballistic_ = false;
+    beginTick();
+}
+
+void Player::startSegment()
+{
+    climbed_ += riseAfter(seg_dy_, seg_t_);
+    seg_x_ = x_;
+    seg_y_ = y_;
+    seg_dy_ = standing_on_floor_ ? 0.0 : dy_;
+    seg_t_ = 0.0;
 }
 
-bool Player::touches(Sprite *other)
+double Player::yAfter(double t) const
+{
+    if (standing_on_floor_)
+        return y_;
+    return seg_y_ + heightAfter(seg_dy_, seg_t_ + t);
+}
+
+double Player::timeToReachY(double y) const
+{
+    constexpr double NEVER = std::numeric_limits<double>::infinity();
+    if (standing_on_floor_)
+        return y == y_ ? 0.0 : NEVER;
+    // seg_y_ + seg_dy_ * s - s^2 / 2 = y, for the first s that isn't in the past
+    const double disc = seg_dy_ * seg_dy_ - 2.0 * (y - seg_y_);
+    if (disc < 0.0)
+        return NEVER;
+    const double root = std::sqrt(disc);
+    for (const double s : {seg_dy_ - root, seg_dy_ + root})
+        if (s >= seg_t_)
+            return s - seg_t_;
+    return NEVER;
+}
+
+std::pair<double, double> Player::yRangeWithin(double t) const
+{
+    if (standing_on_floor_)
+        return {y_, y_};
+    // a parabola: lowest at one end, highest at the top of the arc if that comes before the end
+    return {std::min(y_, yAfter(t)), yAfter(std::clamp(dy_, 0.0, t))};
+}
+
+double Player::timeToTouch(double x, double y, double dx, double dy, unsigned short width, unsigned short height,
+                           double dt) const
+{
+    constexpr double NEVER = std::numeric_limits<double>::infinity();
+    const double reach_x = double((this->width_ + width) / 2) + std::abs(dx_) * dt + 1.0;
+    const double reach_y = double(this->height_ + height / 2) + 1.0;
+
+    // the y-offset from the rectangle t from now is a * t^2 + b * t + c
+    const double a = standing_on_floor_ ? 0.0 : -0.5;
+    const double b = (standing_on_floor_ ? 0.0 : dy_) - dy, c = this->y_ - y;
+
+    // the player moves along the x-axis until it reaches the edge of the screen at t = edge, then stays there
+    const double BORDER_X = (int(screen_width) - this->width_) / 2;
+    const double edge_x = dx_ > 0.0 ? BORDER_X : -BORDER_X;
+    const double edge = dx_ == 0.0 ? NEVER : std::max((edge_x - seg_x_) / dx_ - seg_t_, 0.0);
+
+    double first = NEVER;
+    // over [t0, t1], the x-offset is ex + vx * t
+    auto piece = [&](double t0, double t1, double ex, double vx) {
+        if (vx == 0.0) {
+            if (std::abs(ex) >= reach_x)
+                return;
+        } else {
+            const double enter = (-reach_x - ex) / vx, leave = (reach_x - ex) / vx;
+            t0 = std::max(t0, std::min(enter, leave));
+            t1 = std::min(t1, std::max(enter, leave));
+        }
+        if (t0 <= t1)
+            first = std::min(first, firstTimeWithin(a, b, c, reach_y, t0, t1));
+    };
+    piece(0.0, edge, this->x_ - x, dx_ - dx);
+    if (edge < NEVER)
+        piece(edge, NEVER, edge_x - x, -dx);
+    return first;
+}
+
+bool Player::touches(double x, double y, unsigned short width, unsigned short height) const
 {
     /* If y-difference is less than their combines height */
-    if (std::abs(this->y_ - other->y()) < (this->height_ + other->height() / 2)) {
+    if (std::abs(this->y_ - y) < (this->height_ + height / 2)) {
         /* If x-difference is less than their combined width */
-        if (std::abs(this->x_ - other->x()) < (this->width_ + other->width()) / 2) {
+        if (std::abs(this->x_ - x) < (this->width_ + width) / 2) {
             return true;
         }
     }
     return false;
 }
 
+bool Player::touchedDuringTick(double prev_x, double prev_y, double x, double y, unsigned short width,
+                               unsigned short height) const
+{
+    if (touches(x, y, width, height))
+        return true;
+    if (tick_dt_ <= 0.0)
+        return false;
+
+    /* With u going from 0 to 1 over the tick, the player's offset from the rectangle is linear in u on the
+     * x-axis and quadratic on the y-axis (gravity). They touch while it is within reach on both axes. */
+    const double reach_x = double((this->width_ + width) / 2), reach_y = double(this->height_ + height / 2);
+
+    // [lo, hi]: when the x-offset is within reach
+    const double ex = this->prev_x_ - prev_x, dx = (this->x_ - this->prev_x_) - (x - prev_x);
+    double lo = 0.0, hi = 1.0;
+    if (dx == 0.0) {
+        if (std::abs(ex) >= reach_x)
+            return false;
+    } else {
+        double enter = (-reach_x - ex) / dx, leave = (reach_x - ex) / dx;
+        if (enter > leave)
+            std::swap(enter, leave);
+        lo = std::max(lo, enter);
+        hi = std::min(hi, leave);
+        if (lo >= hi)
+            return false;
+    }
+
+    // the y-offset is a * u^2 + b * u + c; they touch if its range over [lo, hi] overlaps (-reach_y, reach_y)
+    const double a = tick_ballistic_ ? -tick_dt_ * tick_dt_ / 2.0 : 0.0;
+    const double b = tick_dy_ * tick_dt_ - (y - prev_y), c = this->prev_y_ - prev_y;
+    auto offset = [&](double u) { return (a * u + b) * u + c; };
+    double min_y = std::min(offset(lo), offset(hi)), max_y = std::max(offset(lo), offset(hi));
+    if (a != 0.0)
+        if (const double apex = -b / (2.0 * a); lo < apex && apex < hi) {
+            min_y = std::min(min_y, offset(apex));
+            max_y = std::max(max_y, offset(apex));
+        }
+    return min_y < reach_y && max_y > -reach_y;
+}
+
 void Player::takeAction(double dt)
 {
     incrTicksElapsed(dt);
+    tick_dt_ = dt;
+    tick_dy_ = standing_on_floor_ ? 0.0 : dy_;
+    tick_ballistic_ = !standing_on_floor_;
+
+    /* Positions are worked out from the start of the segment rather than stepped, so they don't depend on dt */
+    seg_t_ += dt;
 
     /* X-axis - Make sure that the player does not escape the screen
      * NB that x:0 is in the middle of the screen */
-    const double NEW_X = this->x_ + this->dx_ * dt;
-    const signed BORDER_X = (int(screen_width) - this->width_) / 2;
+    const double BORDER_X = (int(screen_width) - this->width_) / 2;
+    this->x_ = std::clamp(seg_x_ + this->dx_ * seg_t_, -BORDER_X, BORDER_X);
 
-    if (this->dx_ != 0.0 && NEW_X >= -BORDER_X && NEW_X <= BORDER_X)
-        this->x_ = NEW_X;
-
-    /* Y-axis */
-    if (this->dy_ != 0.0 || this->y_ > 0.0) {
-        this->y_ += this->dy_ * dt;
-        this->dy_ -= 1.0 * dt;
-
-        /* If we gain height, gain score */
-        if (this->dy_ > 0.0)
-            this->score_ += std::round(this->dy_ * dt);
+    /* Y-axis - gravity, once the player has left the floor */
+    if (!standing_on_floor_) {
+        this->y_ = seg_y_ + heightAfter(seg_dy_, seg_t_);
+        this->dy_ = seg_dy_ - seg_t_;
     }
 
     // if player moving up or on the floor, increment internal image index
@@ -85,6 +238,7 @@ bool Player::jump(int force_push_level)
         dy_ = std::min(dy_, SPEED_LIMIT); // limit speed to something sane (if too high, game becomes too easy)
         this->standing_on_floor_ = false; // never allow them to use the jetpack again!
         last_jump_ticks_ = ticks_elapsed_;
+        startSegment();
         return true;
     } else if (this->standing_on_floor_) {
         /* If we manually jump, remove standing_on_floor_ and recurse */
@@ -105,11 +259,12 @@ void Player::move(short dx)
         this->facing_direction_ = false;
     } else
         this->dx_ = 0.0;
+    startSegment();
 }
 
-size_t Player::score() const { return this->score_ / 10; }
+size_t Player::score() const { return size_t((climbed_ + riseAfter(seg_dy_, seg_t_)) / 10.0); }
 
-short Player::imageX()
+short Player::imageX() const
 {
     /* If standing on ground and moving, the walking images are 3-4 */
     if (this->standing_on_floor_ and this->dx_ != 0.0)
@@ -125,10 +280,59 @@ short Player::imageX()
 
 bool Player::isJetpackLit() const
 {
-    constexpr unsigned recent_ms = 500;
+    constexpr double recent_ms = 500.0;
     return dy_ > 0.0 && ticks_elapsed_ - last_jump_ticks_ < recent_ms;
 }
 
 short Player::imageY() const { return this->facing_direction_ * this->height_; }
 
 double Player::velocity() const { return std::sqrt(dx_ * dx_ + dy_ * dy_); }
+
+auto Player::state() const -> State
+{
+    // value-initialized first so the padding after the flags is zero too, and equal states save equal bytes
+    State s = State();
+    s.x = x_;
+    s.y = y_;
+    s.prev_x = prev_x_;
+    s.prev_y = prev_y_;
+    s.dx = dx_;
+    s.dy = dy_;
+    s.seg_x = seg_x_;
+    s.seg_y = seg_y_;
+    s.seg_dy = seg_dy_;
+    s.seg_t = seg_t_;
+    s.climbed = climbed_;
+    s.tick_dt = tick_dt_;
+    s.tick_dy = tick_dy_;
+    s.last_jump_ticks = last_jump_ticks_;
+    s.ticks_elapsed = ticks_elapsed_;
+    s.cum_image_dt = cum_image_dt;
+    s.standing_on_floor = standing_on_floor_;
+    s.facing_direction = facing_direction_;
+    s.tick_ballistic = tick_ballistic_;
+    return s;
+}
+
+void Player::setState(const State &s)
+{
+    x_ = s.x;
+    y_ = s.y;
+    prev_x_ = s.prev_x;
+    prev_y_ = s.prev_y;
+    dx_ = s.dx;
+    dy_ = s.dy;
+    seg_x_ = s.seg_x;
+    seg_y_ = s.seg_y;
+    seg_dy_ = s.seg_dy;
+    seg_t_ = s.seg_t;
+    climbed_ = s.climbed;
+    tick_dt_ = s.tick_dt;
+    tick_dy_ = s.tick_dy;
+    last_jump_ticks_ = s.last_jump_ticks;
+    ticks_elapsed_ = s.ticks_elapsed;
+    cum_image_dt = s.cum_image_dt;
+    standing_on_floor_ = s.standing_on_floor;
+    facing_direction_ = s.facing_direction;
+    tick_ballistic_ = s.tick_ballistic;
+}
@@ -12,9 +12,14 @@
 
 #include "Sprite.h"
 #include <cstdint>
+#include <utility>
 
 /*!
  * \brief Player class
+ *
+ * Between jumps and changes of direction the player flies a ballistic segment: x(t) = x0 + dx * t (stopping at
+ * the edges of the screen) and y(t) = y0 + dy * t - t^2 / 2. Positions and score are worked out from the start
+ * of the current segment rather than stepped, so they come out the same whatever dt the simulation runs at.
  */
 class Player : public Sprite
 {
@@ -31,17 +36,52 @@ public:
     void reset();
 
     /*!
-     * \brief Check if player touches another Sprite class
-     * \param other Sprite to check if they touch
+     * \brief Check if player touches a rectangle centered on (x, y), such as a star in a StarPool
      * \return true if they touch
      */
-    bool touches(Sprite *other);
+    bool touches(double x, double y, unsigned short width, unsigned short height) const;
+
+    /*!
+     * \brief Check if player touched a rectangle at any point during the current tick
+     *
+     * The rectangle is taken to move in a straight line from where it was at the start of the tick to where it
+     * is now. The player moves in a straight line on the x-axis, and along the arc gravity gave it on the y-axis
+     * (from the dy and dt of the last takeAction()). The test finds when in the tick the two are within reach
+     * on the x-axis, then checks whether the y-offset between them, which is quadratic in time, comes within reach
+     * during that stretch. Nothing is missed however far they moved.
+     * \param prev_x x of the rectangle's center at the start of the tick
+     * \param prev_y y of the rectangle's center at the start of the tick
+     * \return true if they touched; always true if touches(x, y, width, height) is
+     */
+    bool touchedDuringTick(double prev_x, double prev_y, double x, double y, unsigned short width,
+                           unsigned short height) const;
 
     /*!
      * \brief Manages player's movement depending on dx and dy
      */
     void takeAction(double dt) override;
 
+    /// \return the player's y-position t from now, if nothing makes it jump before then
+    double yAfter(double t) const;
+
+    /// \return how long until the player is at height y, if nothing makes it jump before then; infinity if never
+    double timeToReachY(double y) const;
+
+    /// \return the lowest and highest y-positions of the player over the next t, if nothing makes it jump
+    std::pair<double, double> yRangeWithin(double t) const;
+
+    /*!
+     * \brief How long until the player touches a rectangle moving in a straight line, if nothing makes it jump
+     *
+     * Errs early rather than late: it allows a pixel for rounding, and for touchedDuringTick() cutting the corner
+     * where the player stops at the edge of the screen part way through a tick of dt.
+     * \param dx x-axis movement of the rectangle per unit of dt
+     * \param dy y-axis movement of the rectangle per unit of dt
+     * \return a time no later than the end of the first tick whose touchedDuringTick() would be true; infinity if never
+     */
+    double timeToTouch(double x, double y, double dx, double dy, unsigned short width, unsigned short height,
+                       double dt) const;
+
     /*!
      * \brief Jump a short distance into the air
      * \param force_push_level==0, this is due to the player jumping, 1 = normal star, >1 = moving star
@@ -56,7 +96,7 @@ public:
     void move(short dx);
 
     /*!
-     * \return the current player score
+     * \return the current player score: a tenth of the height gained while rising
      */
     size_t score() const;
 
@@ -69,7 +109,7 @@ public:
      * Player image is a bit special so it has its own imageX()
      * \return x of the image the Sprite wants to draw
      */
-    short imageX() override;
+    short imageX() const override;
 
     /*!
      * \returns y of the image the Sprite wants to draw
@@ -86,12 +126,39 @@ public:
      */
     bool isJetpackLit() const;
 
+    /// Everything about the player that changes as the game goes on, as plain values for a Snapshot
+    struct State {
+        double x, y, prev_x, prev_y, dx, dy;
+        double seg_x, seg_y, seg_dy, seg_t, climbed;
+        double tick_dt, tick_dy;
+        double last_jump_ticks, ticks_elapsed, cum_image_dt;
+        bool standing_on_floor, facing_direction, tick_ballistic;
+    };
+
+    /// \return the player's current State
+    State state() const;
+
+    /// Put the player back in a State returned by state()
+    void setState(const State &s);
+
 private:
     const unsigned screen_width;  /*!< X-axis width of play area */
     double dx_ = 0.;              /*!< Current x-axis movement */
     double dy_ = 0.;              /*!< Current y-axis movement */
     bool standing_on_floor_;      /*!< True if player has not yet jumped */
-    size_t score_;                /*!< Current player score */
     bool facing_direction_;       /*!< Direction the player is facing, false = right */
-    unsigned last_jump_ticks_ = 0;
+    double last_jump_ticks_ = 0.0;
+
+    double seg_x_ = 0.;           /*!< x-position at the start of the current segment */
+    double seg_y_ = 0.;           /*!< y-position at the start of the current segment */
+    double seg_dy_ = 0.;          /*!< y-axis movement at the start of the current segment */
+    double seg_t_ = 0.;           /*!< Time since the start of the current segment */
+    double climbed_ = 0.;         /*!< Height gained while rising, in earlier segments */
+
+    double tick_dt_ = 0.;         /*!< dt of the last takeAction(), for touchedDuringTick() */
+    double tick_dy_ = 0.;         /*!< y-axis movement at the start of the last takeAction() */
+    bool tick_ballistic_ = false; /*!< True if gravity applied during the last takeAction() */
+
+    /// Start a new segment from the current position and movement, e.g. after a jump
+    void startSegment();
 };
@@ -0,0 +1,98 @@
+/*!
+ * \file Profiler.cpp
+ * \brief File containing the Profiler source code
+ *
+ * \copyright GNU Public License
+ */
+#include "Profiler.h"
+
+#include "tinyformat.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+/// One thread's zones. Only the owning thread writes; WriteChromeTrace() may read from any thread.
+struct ThreadBuffer {
+    explicit ThreadBuffer(unsigned t) : tid(t) {}
+    const unsigned tid;
+    std::atomic<std::uint64_t> written{0}; ///< total number of events ever written
+    std::array<Profiler::Event, Profiler::ZONES_PER_THREAD> events{};
+};
+
+/// Owns every thread's buffer, so that zones of threads that have exited can still be dumped
+struct Registry {
+    std::mutex lock; ///< only taken when a thread records its first zone, and when dumping
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+};
+
+Registry &GetRegistry()
+{
+    static Registry registry;
+    return registry;
+}
+
+ThreadBuffer &GetThreadBuffer()
+{
+    thread_local ThreadBuffer *buf = [] {
+        Registry &reg = GetRegistry();
+        std::lock_guard g(reg.lock);
+        return reg.buffers.emplace_back(std::make_unique<ThreadBuffer>(unsigned(reg.buffers.size()) + 1)).get();
+    }();
+    return *buf;
+}
+
+} // namespace
+
+/* static */
+std::uint64_t Profiler::Now()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+/* static */
+void Profiler::Record(const Event &event)
+{
+    ThreadBuffer &buf = GetThreadBuffer();
+    const std::uint64_t n = buf.written.load(std::memory_order_relaxed);
+    buf.events[n % ZONES_PER_THREAD] = event;
+    buf.written.store(n + 1, std::memory_order_release);
+}
+
+/* static */
+bool Profiler::WriteChromeTrace(const std::string &filename)
+{
+    if constexpr (!Enabled)
+        return false;
+
+    std::ofstream f(filename);
+    if (!f)
+        return false;
+
+    Registry &reg = GetRegistry();
+    std::lock_guard g(reg.lock);
+
+    f << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+    const char *sep = "\n";
+    for (const auto &buf : reg.buffers) {
+        const std::uint64_t end = buf->written.load(std::memory_order_acquire);
+        // skip a few of the oldest events: the owning thread may be overwriting them while we read
+        constexpr std::uint64_t SLACK = 64;
+        const std::uint64_t begin = end > ZONES_PER_THREAD - SLACK ? end - (ZONES_PER_THREAD - SLACK) : 0;
+        for (std::uint64_t i = begin; i < end; ++i) {
+            const Event &e = buf->events[i % ZONES_PER_THREAD];
+            f << sep << strprintf("{\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f}",
+                                  e.name, buf->tid, e.begin_ns / 1000.0, (e.end_ns - e.begin_ns) / 1000.0);
+            sep = ",\n";
+        }
+    }
+    f << "\n]}\n";
+    return bool(f);
+}
@@ -0,0 +1,73 @@
+/*!
+ * \file Profiler.h
+ * \brief File containing the scoped timing zones (PROFILE_ZONE) and the Chrome trace writer
+ *
+ * \copyright GNU Public License
+ *
+ * Put PROFILE_ZONE("name") at the top of a scope to time it. Zones are recorded into a fixed-size ring buffer
+ * owned by the calling thread (no locks, no allocation), and Profiler::WriteChromeTrace() dumps the most recent
+ * ones in the Chrome trace event format, which chrome://tracing and https://ui.perfetto.dev can open.
+ *
+ * Unless the build defines JUMPMAN_PROFILE (cmake -DJUMPMAN_PROFILE=ON), PROFILE_ZONE compiles to nothing.
+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#ifdef JUMPMAN_PROFILE
+#  define PROFILE_CONCAT_(a, b) a##b
+#  define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#  define PROFILE_ZONE(name) const Profiler::Zone PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+#else
+#  define PROFILE_ZONE(name) static_cast<void>(0)
+#endif
+
+/*!
+ * \class Profiler
+ * \brief Static interface to the per-thread zone buffers
+ */
+class Profiler
+{
+public:
+    /// True if this build records zones
+#ifdef JUMPMAN_PROFILE
+    static constexpr bool Enabled = true;
+#else
+    static constexpr bool Enabled = false;
+#endif
+
+    /// Number of zones each thread keeps; older ones are overwritten
+    static constexpr unsigned ZONES_PER_THREAD = 1u << 16;
+
+    /// A completed zone
+    struct Event {
+        const char *name;        ///< must be a string literal (or otherwise outlive the profiler)
+        std::uint64_t begin_ns;
+        std::uint64_t end_ns;
+    };
+
+    /// RAII timing zone; use via PROFILE_ZONE
+    class Zone {
+    public:
+        explicit Zone(const char *name) : name_(name), begin_ns_(Now()) {}
+        ~Zone() { Record({name_, begin_ns_, Now()}); }
+        Zone(const Zone &) = delete;
+        void operator=(const Zone &) = delete;
+    private:
+        const char * const name_;
+        const std::uint64_t begin_ns_;
+    };
+
+    /// \return a monotonic timestamp in nanoseconds
+    static std::uint64_t Now();
+
+    /// Append a completed zone to the calling thread's ring buffer
+    static void Record(const Event &event);
+
+    /*!
+     * \brief Write the zones currently held by all threads' buffers to filename, as a Chrome trace (JSON)
+     * \return false if the file could not be written or profiling is compiled out
+     */
+    static bool WriteChromeTrace(const std::string &filename);
+};
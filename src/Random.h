@@ -0,0 +1,48 @@
+/*!
+ * \file Random.h
+ * \brief File containing the counter-based random number generator used by the simulation
+ *
+ * \copyright GNU Public License
+ */
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+
+/// SplitMix64 finalizer; a fast bijective mix of all 64 input bits into all 64 output bits
+constexpr std::uint64_t SplitMix64(std::uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/*!
+ * \class SpawnRng
+ * \brief Counter-based random number stream for a single star spawn
+ *
+ * The n-th number drawn is SplitMix64 of (seed, spawn index, n), so every spawn is a pure function of the game's
+ * seed and the spawn's index. There is no shared state, so any number of simulations can run in parallel, and
+ * the same seed always produces the same level.
+ */
+class SpawnRng
+{
+public:
+    SpawnRng(std::uint64_t seed, std::uint64_t spawn_index)
+        : key_(SplitMix64(seed ^ SplitMix64(spawn_index + GOLDEN_GAMMA))) {}
+
+    /// \return the next 64 random bits of this stream
+    std::uint64_t next() { return SplitMix64(key_ + GOLDEN_GAMMA * ++counter_); }
+
+    /// \return a random number in the range [from, to]
+    int range(int from, int to) {
+        assert(to >= from);
+        const std::uint64_t span = std::uint64_t(std::int64_t(to) - from) + 1;
+        return int(from + std::int64_t(((next() >> 32) * span) >> 32));
+    }
+
+private:
+    static constexpr std::uint64_t GOLDEN_GAMMA = 0x9e3779b97f4a7c15ULL;
+    const std::uint64_t key_;
+    std::uint64_t counter_ = 0;
+};
@@ -0,0 +1,137 @@
+/*!
+ * \file Replay.cpp
+ * \brief File containing the ReplayWriter and ReplayReader source code
+ *
+ * \copyright GNU Public License
+ */
+#include "Replay.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace {
+constexpr char MAGIC[4] = {'J', 'M', 'R', 'P'};
+// bumped whenever the rules change in a way that makes old replays play out differently:
+// 2 = stars are touched anywhere along the player's path during a tick, not just where it ends up
+// 3 = world coordinates: nothing is narrowed to whole pixels, and the camera scrolls by fractions of a pixel
+// 4 = moving stars' positions are worked out from the time since they spawned rather than added up tick by tick
+// 5 = the player flies exact parabolas, and score is the exact height gained while rising
+constexpr unsigned VERSION = 5;
+constexpr unsigned END_CODE = 7;
+constexpr unsigned CODE_BITS = 3;
+static_assert(unsigned(ReplayEvent::PausePlay) < END_CODE);
+} // namespace
+
+ReplayWriter::ReplayWriter(const std::string &filename, const ReplayHeader &header)
+    : out_(filename, std::ios::binary | std::ios::trunc)
+{
+    out_.write(MAGIC, sizeof(MAGIC));
+    putVarint(VERSION);
+    for (int i = 0; i < 8; ++i)
+        out_.put(static_cast<char>(header.seed >> (8 * i)));
+    putVarint(header.sim_rate);
+    putVarint(header.screen_width);
+    putVarint(header.screen_height);
+}
+
+ReplayWriter::~ReplayWriter() { out_.flush(); }
+
+void ReplayWriter::putVarint(std::uint64_t v)
+{
+    while (v >= 0x80) {
+        out_.put(static_cast<char>((v & 0x7f) | 0x80));
+        v >>= 7;
+    }
+    out_.put(static_cast<char>(v));
+}
+
+void ReplayWriter::putRecord(std::uint64_t tick, unsigned code)
+{
+    assert(tick >= last_tick_);
+    putVarint(((tick - last_tick_) << CODE_BITS) | code);
+    last_tick_ = tick;
+}
+
+void ReplayWriter::add(std::uint64_t tick, ReplayEvent event)
+{
+    if (finished_) return;
+    putRecord(tick, unsigned(event));
+}
+
+void ReplayWriter::finish(std::uint64_t tick, std::size_t score)
+{
+    if (finished_) return;
+    putRecord(tick, END_CODE);
+    putVarint(score);
+    out_.flush();
+    finished_ = true;
+}
+
+ReplayReader::ReplayReader(const std::string &filename)
+    : in_(filename, std::ios::binary)
+{
+    char magic[sizeof(MAGIC)] = {};
+    if (!in_ || !in_.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), MAGIC)) {
+        error_ = "Not a replay file: " + filename;
+        return;
+    }
+    if (getVarint() != VERSION) {
+        error_ = "Unsupported replay version: " + filename;
+        return;
+    }
+    for (int i = 0; i < 8; ++i)
+        header_.seed |= std::uint64_t(static_cast<unsigned char>(in_.get())) << (8 * i);
+    const auto rate = getVarint(), width = getVarint(), height = getVarint();
+    if (!in_ || !rate || !width || !height) {
+        error_ = "Truncated replay header: " + filename;
+        return;
+    }
+    header_.sim_rate = unsigned(*rate);
+    header_.screen_width = unsigned(*width);
+    header_.screen_height = unsigned(*height);
+    readNext();
+}
+
+std::optional<std::uint64_t> ReplayReader::getVarint()
+{
+    std::uint64_t v = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        const int c = in_.get();
+        if (c == std::char_traits<char>::eof())
+            return std::nullopt;
+        v |= std::uint64_t(c & 0x7f) << shift;
+        if (!(c & 0x80))
+            return v;
+    }
+    return std::nullopt; // overlong
+}
+
+void ReplayReader::pop()
+{
+    if (pending_)
+        readNext();
+}
+
+void ReplayReader::readNext()
+{
+    pending_.reset();
+    if (end_ || !ok())
+        return;
+
+    const auto rec = getVarint();
+    if (!rec)
+        return; // no end record; the writer was not finish()ed (e.g. the user quit mid-game)
+
+    const unsigned code = *rec & ((1u << CODE_BITS) - 1);
+    last_tick_ += *rec >> CODE_BITS;
+    if (code == END_CODE) {
+        const auto score = getVarint();
+        if (!score)
+            error_ = "Truncated replay end record";
+        else
+            end_ = End{last_tick_, std::size_t(*score)};
+    } else if (code > unsigned(ReplayEvent::PausePlay))
+        error_ = "Corrupt replay record";
+    else
+        pending_ = Entry{last_tick_, ReplayEvent(code)};
+}
@@ -0,0 +1,155 @@
+/*!
+ * \file Replay.h
+ * \brief File containing the input recording (ReplayWriter) and playback (ReplayReader) classes
+ *
+ * \copyright GNU Public License
+ *
+ * A replay is the game's seed plus every input the player gave, stamped with the simulation tick it was applied
+ * before. Since the Simulation is deterministic, that is all that is needed to reproduce a run bit-exactly.
+ *
+ * File format (all integers are unsigned LEB128 varints unless noted):
+ *
+ *     "JMRP" (4 bytes) | version | seed (8 bytes, little endian) | sim_rate | screen_width | screen_height
+ *     records...
+ *
+ * Each record is one varint: (tick - previous record's tick) << 3 | code, where code is a ReplayEvent value or
+ * END_CODE. An END_CODE record is followed by a varint holding the final score. A typical record is a single
+ * byte, so even hour-long runs stay a few KB.
+ */
+#pragma once
+
+#include "Common.h"
+#include "Simulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+
+/*!
+ * \enum ReplayEvent
+ * \brief The inputs recorded in a replay. The first four map 1:1 onto Simulation::Input
+ */
+enum class ReplayEvent : std::uint8_t {
+    Left = std::uint8_t(Simulation::Input::Left),   /*!< Player wants to move left */
+    Right = std::uint8_t(Simulation::Input::Right), /*!< Player wants to move right */
+    Up = std::uint8_t(Simulation::Input::Up),       /*!< Player wants to jump */
+    Still = std::uint8_t(Simulation::Input::Still), /*!< Player wants to stop moving */
+    PausePlay,                                      /*!< Player paused/unpaused; has no effect on the simulation */
+};
+
+/// \return the Simulation::Input for event, or nothing if the event does not affect the simulation
+inline std::optional<Simulation::Input> toSimInput(ReplayEvent event)
+{
+    if (event == ReplayEvent::PausePlay) return std::nullopt;
+    return Simulation::Input(event);
+}
+
+/// Everything besides the inputs that is needed to reproduce a run
+struct ReplayHeader {
+    std::uint64_t seed = 0;
+    unsigned sim_rate = DEFAULT_SIM_RATE;
+    unsigned screen_width = 0;
+    unsigned screen_height = 0;
+};
+
+/*!
+ * \class ReplayWriter
+ * \brief Streams a replay to disk as the game is played
+ */
+class ReplayWriter
+{
+public:
+    /// Creates (or truncates) filename and writes the header
+    ReplayWriter(const std::string &filename, const ReplayHeader &header);
+
+    /// Disabled copy constructor
+    ReplayWriter(const ReplayWriter &) = delete;
+
+    /// Destructor. Flushes the file; a replay without an end record is still readable.
+    ~ReplayWriter();
+
+    /// Disabled copy constructor
+    void operator=(const ReplayWriter &) = delete;
+
+    /// \return false if the file could not be opened or written
+    bool ok() const { return bool(out_); }
+
+    /*!
+     * \brief Record an input
+     * \param tick the simulation tick the input was applied before; must not decrease between calls
+     * \param event the input
+     */
+    void add(std::uint64_t tick, ReplayEvent event);
+
+    /*!
+     * \brief Record the end of the run; further calls to add() or finish() are ignored
+     * \param tick the tick count at which the game ended
+     * \param score the final score, so that playback can verify it
+     */
+    void finish(std::uint64_t tick, std::size_t score);
+
+private:
+    void putVarint(std::uint64_t v);
+    void putRecord(std::uint64_t tick, unsigned code);
+
+    std::ofstream out_;
+    std::uint64_t last_tick_ = 0;
+    bool finished_ = false;
+};
+
+/*!
+ * \class ReplayReader
+ * \brief Reads a replay written by ReplayWriter, one record at a time
+ */
+class ReplayReader
+{
+public:
+    /// Opens filename and reads the header; check ok() afterwards
+    explicit ReplayReader(const std::string &filename);
+
+    /// Disabled copy constructor
+    ReplayReader(const ReplayReader &) = delete;
+
+    /// Disabled copy constructor
+    void operator=(const ReplayReader &) = delete;
+
+    /// \return false if the file could not be read or is corrupt; see error()
+    bool ok() const { return error_.empty(); }
+
+    /// \return a string describing what went wrong, or an empty string
+    const std::string &error() const { return error_; }
+
+    const ReplayHeader &header() const { return header_; }
+
+    /// A recorded input
+    struct Entry {
+        std::uint64_t tick;
+        ReplayEvent event;
+    };
+
+    /// \return the next input without consuming it, or nullptr if there are no more
+    const Entry *peek() const { return pending_ ? &*pending_ : nullptr; }
+
+    /// Consume the input returned by peek()
+    void pop();
+
+    /// Set once the end record has been reached: the final tick and score of the recorded run
+    struct End {
+        std::uint64_t tick;
+        std::size_t score;
+    };
+    const std::optional<End> &end() const { return end_; }
+
+private:
+    std::optional<std::uint64_t> getVarint();
+    void readNext();
+
+    std::ifstream in_;
+    std::string error_;
+    ReplayHeader header_;
+    std::uint64_t last_tick_ = 0;
+    std::optional<Entry> pending_;
+    std::optional<End> end_;
+};
@@ -0,0 +1,97 @@
+/*!
+ * \file Rewind.cpp
+ * \brief File containing the Rewind class source code
+ *
+ * \copyright GNU Public License
+ */
+#include "Rewind.h"
+
+#include "FixedTimestep.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+Rewind::Rewind(unsigned sim_rate, double seconds, std::size_t budget_bytes)
+    : dt_(FixedTimestep(sim_rate).tickDT()),
+      interval_(std::max(sim_rate / REWIND_KEYFRAMES_PER_SECOND, 1u)),
+      max_ticks_(std::uint64_t(std::max(std::llround(seconds * sim_rate), 1ll))),
+      budget_bytes_(budget_bytes)
+{
+    keyframes_.reserve(std::size_t(max_ticks_ / interval_ + 2));
+}
+
+void Rewind::start(const Simulation &sim)
+{
+    while (!keyframes_.empty())
+        dropOldest();
+    inputs_.clear();
+    ticked(sim);
+}
+
+void Rewind::input(std::uint64_t tick, Simulation::Input input)
+{
+    inputs_.push(tick, input);
+}
+
+void Rewind::ticked(const Simulation &sim)
+{
+    const std::uint64_t tick = sim.tick();
+    if (!keyframes_.empty() && tick % interval_ != 0)
+        return;
+    PROFILE_ZONE("Rewind::keyframe");
+    bytes_ -= spare_.capacity();
+    {
+        SnapshotWriter w(spare_);
+        sim.save(w);
+    }
+    bytes_ += spare_.capacity();
+    keyframes_.push(tick, std::move(spare_));
+    spare_ = Snapshot();
+    // keep the newest keyframe that is at least max_ticks_ old, so that all of the last max_ticks_ can be reached
+    while (keyframes_.size() > 1
+           && (keyframes_.key(keyframes_.first() + 1) + max_ticks_ <= tick || bytes_ > budget_bytes_))
+        dropOldest();
+}
+
+std::uint64_t Rewind::stepBack(Simulation &sim, std::uint64_t ticks)
+{
+    const std::uint64_t now = sim.tick();
+    if (keyframes_.empty() || now <= oldestTick())
+        return 0;
+    PROFILE_ZONE("Rewind::stepBack");
+    const std::uint64_t target = now - std::min(ticks, now - oldestTick());
+
+    // the latest keyframe at or before target; whatever comes after target is forgotten
+    const Seq k = keyframes_.upperBound(target) - 1;
+    SnapshotReader r(keyframes_.get<0>(k));
+    if (!sim.restore(r))
+        return 0;
+    for (Seq s = keyframes_.last(); s-- > k + 1;) {
+        bytes_ -= keyframes_.get<0>(s).capacity();
+        Snapshot().swap(keyframes_.get<0>(s));
+    }
+    keyframes_.truncate(k + 1);
+
+    // play the inputs since the keyframe again, up to target
+    for (Seq i = inputs_.lowerBound(sim.tick()); sim.tick() < target; sim.letObjectsInteract(dt_))
+        for (; i < inputs_.last() && inputs_.key(i) <= sim.tick(); ++i)
+            sim.handleInput(inputs_.get<0>(i));
+    inputs_.truncate(inputs_.lowerBound(target));
+    return now - target;
+}
+
+void Rewind::dropOldest()
+{
+    Snapshot &oldest = keyframes_.get<0>(keyframes_.first());
+    if (oldest.capacity() > spare_.capacity())
+        spare_.swap(oldest);
+    bytes_ -= oldest.capacity();
+    Snapshot().swap(oldest);
+    keyframes_.pop();
+    if (keyframes_.empty())
+        return;
+    const std::uint64_t tick = oldestTick();
+    while (!inputs_.empty() && inputs_.key(inputs_.first()) < tick)
+        inputs_.pop();
+}
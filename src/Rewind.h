@@ -0,0 +1,94 @@
+/*!
+ * \file Rewind.h
+ * \brief File containing the Rewind class, the recent history of a game that it can be played back through
+ *
+ * \copyright GNU Public License
+ *
+ * The history is a Snapshot of the Simulation every so many ticks (a keyframe) plus every input given since the
+ * oldest one. Since the Simulation is deterministic, the inputs are all that changes from tick to tick: any tick
+ * in between two keyframes is got back by restoring the earlier one and simulating forward again, which takes
+ * at most a keyframe interval's worth of ticks.
+ */
+#pragma once
+
+#include "Simulation.h"
+#include "Snapshot.h"
+#include "SpawnRing.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/// How far back a game can be rewound, in seconds of game time
+inline constexpr double REWIND_SECONDS = 30.0;
+
+/// Most memory the keyframes of a rewind history may take; older ones are dropped to stay within it
+inline constexpr std::size_t REWIND_BUDGET_BYTES = std::size_t(16) << 20;
+
+/// Keyframes kept per second of game time
+inline constexpr unsigned REWIND_KEYFRAMES_PER_SECOND = 8;
+
+/*!
+ * \class Rewind
+ * \brief Keeps the last few seconds of a game, so that it can be stepped back tick by tick
+ *
+ * Call start() when the game starts, input() before each input is handed to the Simulation and ticked() after
+ * each tick. Taking a keyframe costs a Simulation::save() every sim_rate / REWIND_KEYFRAMES_PER_SECOND ticks,
+ * and once the history is full, recording it doesn't allocate.
+ */
+class Rewind
+{
+public:
+    /*!
+     * \param sim_rate simulation ticks per second of the games recorded
+     * \param seconds how much game time to keep
+     * \param budget_bytes how much memory the keyframes may take; at least one is always kept, whatever its size
+     */
+    explicit Rewind(unsigned sim_rate, double seconds = REWIND_SECONDS,
+                    std::size_t budget_bytes = REWIND_BUDGET_BYTES);
+
+    /// Forget the history and start a new one at sim's current state
+    void start(const Simulation &sim);
+
+    /// Record that input is about to be given to the simulation, whose tick() is tick
+    void input(std::uint64_t tick, Simulation::Input input);
+
+    /// Record that sim has just run a tick, taking a keyframe if one is due
+    void ticked(const Simulation &sim);
+
+    /*!
+     * \brief Take sim back up to ticks ticks, but not past the oldest tick in the history
+     *
+     * Everything after the tick it goes back to is forgotten, as playing on from there makes a different future.
+     * \return how many ticks sim went back; 0 if it is at the start of the history already
+     */
+    std::uint64_t stepBack(Simulation &sim, std::uint64_t ticks);
+
+    /// \return the tick() of the oldest state sim can be taken back to
+    std::uint64_t oldestTick() const { return keyframes_.empty() ? 0 : keyframes_.key(keyframes_.first()); }
+
+    /// \return the memory the keyframes take, in bytes
+    std::size_t bytes() const { return bytes_; }
+
+private:
+    using Seq = std::uint64_t;
+
+    const double dt_;                ///< tick length on the physics timescale, for simulating forward again
+    const std::uint64_t interval_;   ///< ticks between keyframes
+    const std::uint64_t max_ticks_;  ///< ticks of history to keep
+    const std::size_t budget_bytes_;
+
+    /// A Snapshot of the simulation every interval_ ticks; keyed on its tick()
+    SpawnRing<std::uint64_t, Snapshot> keyframes_;
+
+    /// Every input since the oldest keyframe; keyed on the tick() it was given at
+    SpawnRing<std::uint64_t, Simulation::Input> inputs_;
+
+    /// The memory of the last keyframe dropped, which the next one is written over
+    Snapshot spare_;
+
+    /// See bytes(); spare_ included
+    std::size_t bytes_ = 0;
+
+    /// Drop the oldest keyframe, and the inputs that only it needed
+    void dropOldest();
+};
@@ -0,0 +1,260 @@
+/*!
+ * \file Simulation.cpp
+ * \brief File containing the Simulation class source code
+ *
+ * \copyright GNU Public License
+ */
+#include "Simulation.h"
+
+#include "Profiler.h"
+#include "Random.h"
+
+#include <algorithm>
+#include <cmath>
+
+Simulation::Simulation(unsigned screen_width, unsigned screen_height, unsigned stars_per_row)
+    : screen_width_(screen_width), screen_height_(screen_height), stars_per_row_(std::max(stars_per_row, 1u)),
+      player_(std::make_unique<Player>(screen_width))
+{
+    // a screenful of rows, each with stars_per_row_ basic stars and as many moving stars if the RNG is with you
+    stars_.reserve((screen_height_ / 50 + 2) * stars_per_row_ * 2);
+}
+
+Simulation::~Simulation() {}
+
+void Simulation::reset(std::uint64_t seed)
+{
+    seed_ = seed;
+    spawn_index_ = 0;
+    tick_ = 0;
+    over_ = false;
+
+    /* Reset Player */
+    player_->reset();
+
+    /* Reset stars */
+    stars_.clear();
+    last_row_y_ = 0.0;
+
+    /* Reset camera */
+    camera_y_ = prev_camera_y_ = 0.0;
+}
+
+bool Simulation::handleInput(Input input)
+{
+    switch (input) {
+    case Input::Left:
+        player_->move(-1);
+        break;
+    case Input::Right:
+        player_->move(1);
+        break;
+    case Input::Still:
+        player_->move(0);
+        break;
+    case Input::Up:
+        return player_->jump();
+    }
+    return false;
+}
+
+int Simulation::letObjectsInteract(double dt, Events *events)
+{
+    PROFILE_ZONE("letObjectsInteract");
+    beginTick(dt);
+
+    /* Remove stars if the player touched them at any point this tick, or they disappear off screen.
+     * Testing the whole path rather than where the player ended up means a big dt can't skip over stars.
+     * The box covers the player's path: the line between where it started and ended, plus how far its arc can
+     * bulge above that line (dt^2 / 8 under a gravity of 1). It is grown by how far the fastest star can have
+     * moved (plus a pixel of slack for rounding) and big enough for the biggest kind of star.
+     * touchedDuringTick() has the final say. */
+    const double x0 = player_->prevX(), y0 = player_->prevY();
+    const double x1 = player_->x(), y1 = player_->y();
+    const double bulge = dt * dt / 8, reach = MAX_STAR_SPEED * dt + 1.0;
+    const StarKernels::Box box = {(x0 + x1) / 2, (y0 + y1 + bulge) / 2,
+                                  (player_->width() + MAX_STAR_WIDTH) / 2 + std::abs(x1 - x0) / 2 + reach,
+                                  player_->height() + MAX_STAR_HEIGHT / 2 + (std::abs(y1 - y0) + bulge) / 2 + reach};
+    stars_.removeIf(box, [&](const StarPool::Star &star) {
+        const StarBehaviour &b = behaviour(star.kind);
+        if (!player_->touchedDuringTick(star.prev_x, star.prev_y, star.x, star.y, b.width, b.height))
+            return false;
+        bool const ok = player_->jump(b.push_level);
+        if (events) {
+            events->star_jumped = events->star_jumped || ok;
+            ++events->stars_touched[std::size_t(star.kind)];
+        }
+        return true;
+    });
+    stars_.despawnBelow(camera_y_);
+
+    /* Add stars if there is room */
+    addStars();
+
+    /* If player falls below the screen - return game over */
+    if (player_->y() < camera_y_ - player_->height() * 2) {
+        over_ = true;
+        return 1;
+    }
+
+    /* If player is above the middle of the screen, move the camera up to center the player */
+    camera_y_ = std::max(camera_y_, player_->y() - screen_height_ / 2.0);
+    return 0;
+}
+
+namespace {
+/// The fixed-size part of a Simulation's snapshot, which comes first; the player and the stars follow
+struct SnapshotHeader {
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t screen_width, screen_height, stars_per_row;
+    std::uint32_t over; ///< not bool, which would leave padding with whatever was on the stack in it
+    std::uint64_t seed, spawn_index, tick;
+    double last_row_y, camera_y, prev_camera_y;
+};
+
+constexpr std::uint32_t SNAPSHOT_MAGIC = 0x53504d4a; // "JMPS"
+} // namespace
+
+void Simulation::save(SnapshotWriter &w) const
+{
+    PROFILE_ZONE("Simulation::save");
+    w.put(SnapshotHeader{SNAPSHOT_MAGIC, SNAPSHOT_VERSION, screen_width_, screen_height_, stars_per_row_, over_,
+                         seed_, spawn_index_, tick_, last_row_y_, camera_y_, prev_camera_y_});
+    w.put(player_->state());
+    stars_.save(w);
+}
+
+bool Simulation::restore(SnapshotReader &r)
+{
+    PROFILE_ZONE("Simulation::restore");
+    SnapshotHeader h;
+    if (!r.get(h) || h.magic != SNAPSHOT_MAGIC || h.version != SNAPSHOT_VERSION || h.screen_width != screen_width_
+            || h.screen_height != screen_height_ || h.stars_per_row != stars_per_row_)
+        return false;
+    Player::State player;
+    if (!r.get(player) || !stars_.restore(r)) {
+        reset(h.seed);
+        return false;
+    }
+    player_->setState(player);
+    seed_ = h.seed;
+    spawn_index_ = h.spawn_index;
+    tick_ = h.tick;
+    over_ = h.over != 0;
+    last_row_y_ = h.last_row_y;
+    camera_y_ = h.camera_y;
+    prev_camera_y_ = h.prev_camera_y;
+    return true;
+}
+
+void Simulation::beginTick(double dt)
+{
+    ++tick_;
+
+    player_->beginTick();
+    prev_camera_y_ = camera_y_;
+
+    // takeAction handles gravity
+    player_->takeAction(dt);
+    stars_.takeAction(dt);
+}
+
+/// How far fastForward() looks ahead in one go. Every star that might come within reach in that time is tested,
+/// so looking further means testing more stars, mostly for runs that something else cuts short anyway.
+inline constexpr double LOOKAHEAD = 20.0;
+
+std::uint64_t Simulation::fastForward(double dt, std::uint64_t max_ticks)
+{
+    PROFILE_ZONE("fastForward");
+    if (max_ticks == 0 || !(dt > 0.0) || stars_.empty())
+        return 0;
+    const Player &player = *player_;
+    // how long until the player is past y, going up or down; 0 if it is already
+    auto untilAbove = [&](double y) { return player.y() > y ? 0.0 : player.timeToReachY(y); };
+    auto untilBelow = [&](double y) { return player.y() < y ? 0.0 : player.timeToReachY(y); };
+
+    /* Find how long until something that needs a full tick could happen. Each bound errs early, with a pixel of
+     * slack against rounding, and nothing past the end of max_ticks matters. */
+    double until = std::min((double(max_ticks) + 1.0) * dt, LOOKAHEAD);
+
+    // dying: the camera can't rise further than the top of the player's arc
+    const double top = player.yRangeWithin(until).second;
+    const double camera_max = std::max(camera_y_, top - screen_height_ / 2.0);
+    until = std::min(until, untilBelow(camera_max - player.height() * 2 + 1.0));
+
+    /* touching a star spawned on the way: rows only spawn if the camera rises, and above the highest one. The
+     * player has to get up to a new star, or the star has to come down to the top of the player's arc. */
+    const double reach_y = player.height() + MAX_STAR_HEIGHT / 2 + 1.0;
+    if (camera_max + 1.0 >= last_row_y_ - screen_height_) {
+        const double low = last_row_y_ + 50 - reach_y;
+        until = std::min(until, std::max(untilAbove(low - MAX_STAR_SPEED * until), (low - top) / MAX_STAR_SPEED));
+    }
+
+    // touching a star that is already here
+    const auto [lowest, highest] = player.yRangeWithin(until);
+    stars_.forEachNear(lowest - reach_y, highest + reach_y, until, [&](const StarPool::Star &star) {
+        if (until < 2.0 * dt)
+            return; // nothing to skip anyway
+        const StarBehaviour &b = behaviour(star.kind);
+        until = std::min(until, player.timeToTouch(star.x, star.y, star.dx, star.dy, b.width, b.height, dt));
+    });
+
+    // nothing can despawn while the camera stays below every star
+    const bool despawn = camera_max + 1.0 >= stars_.floorWithin(until);
+
+    // the tick the event falls in, and one more for rounding, are left for letObjectsInteract()
+    const double quiet = std::floor(until / dt) - 1.0;
+    const std::uint64_t n = quiet <= 0.0 ? 0 : quiet >= double(max_ticks) ? max_ticks : std::uint64_t(quiet);
+    for (std::uint64_t i = 1; i <= n; ++i) {
+        beginTick(dt);
+        if (despawn)
+            stars_.despawnBelow(camera_y_);
+        // addStars() refills an empty pool with a row right above the camera, which the bounds above don't cover
+        const bool refill = stars_.empty();
+        addStars();
+        camera_y_ = std::max(camera_y_, player_->y() - screen_height_ / 2.0);
+        if (refill)
+            return i;
+    }
+    return n;
+}
+
+void Simulation::addStars()
+{
+    PROFILE_ZONE("addStars");
+    /* Make sure there's always at least one star on screen
+     * This is just to avoid an empty level */
+    if (stars_.empty())
+        spawnRow(camera_y_, false);
+
+    /* Make sure there's a basic star every 50 y-pixels,
+     * Also add other types of stars if the RNG is with you */
+    while (last_row_y_ < camera_y_ + screen_height_)
+        spawnRow(last_row_y_, true);
+}
+
+void Simulation::spawnRow(double y, bool moving_stars)
+{
+    const signed half_screen_width = screen_width_ / 2;
+    // a random x-position that keeps a star of this kind fully on screen
+    auto randomX = [&](SpawnRng &rng, StarKind kind) {
+        const int half_width = behaviour(kind).width / 2;
+        return rng.range(-half_screen_width + half_width, half_screen_width - half_width);
+    };
+    SpawnRng rng(seed_, spawn_index_++);
+    last_row_y_ = y + 50;
+
+    for (unsigned i = 0; i < stars_per_row_; ++i) {
+        stars_.spawn(StarKind::Basic, randomX(rng, StarKind::Basic), last_row_y_);
+
+        if (moving_stars && rng.range(0, 6) == 1) {
+            // draw order matters: x, then dx, then dy
+            const int max_speed = behaviour(StarKind::Moving).max_speed;
+            const int x = randomX(rng, StarKind::Moving);
+            const int dx = rng.range(-max_speed, max_speed);
+            const int dy = rng.range(-max_speed, max_speed);
+            stars_.spawn(StarKind::Moving, x, last_row_y_, dx, dy);
+        }
+    }
+}
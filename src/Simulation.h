@@ -0,0 +1,188 @@
+/*!
+ * \file Simulation.h
+ * \brief File containing the Simulation class Header
+ *
+ * \copyright GNU Public License
+ */
+#pragma once
+
+#include "Player.h"
+#include "Snapshot.h"
+#include "StarPool.h"
+
+#include <cstdint>
+#include <memory>
+
+/*!
+ * \class Simulation
+ *
+ * \brief The game rules: the player, the stars, and how they interact.
+ *
+ * Simulation knows nothing about windows, audio or fonts, so it can be stepped as fast as the CPU allows by the
+ * headless runner as well as by Game. Anything the front-end may want to react to (e.g. play a sound) is reported
+ * back via the Events struct.
+ *
+ * Everything lives in world coordinates: x = 0 is the middle of the screen and y = 0 is the floor the player
+ * starts on. Nothing moves when the screen scrolls; a camera follows the player up instead, and front-ends
+ * subtract cameraY() from world y to get screen y.
+ */
+class Simulation
+{
+public:
+    /*!
+     * \brief Constructor
+     * \param screen_width width of the play area
+     * \param screen_height height of the play area
+     * \param stars_per_row how many stars to spawn every 50 y-pixels; 1 is the real game, more is a stress test
+     */
+    Simulation(unsigned screen_width, unsigned screen_height, unsigned stars_per_row = 1);
+
+    /// Disabled copy constructor
+    Simulation(const Simulation &) = delete;
+
+    /// Destructor
+    ~Simulation();
+
+    /// Disabled copy constructor
+    void operator=(const Simulation &) = delete;
+
+    /*!
+     * \brief Reset the simulation to start state
+     * \param seed the level is a pure function of this value; the same seed always gives the same level
+     */
+    void reset(std::uint64_t seed);
+
+    /// \return the seed passed to the last reset()
+    std::uint64_t seed() const { return seed_; }
+
+    /// \return the number of calls to letObjectsInteract() since the last reset(), i.e. the index of the next tick
+    std::uint64_t tick() const { return tick_; }
+
+    /// \return true if letObjectsInteract() has reported the player dead since the last reset()
+    bool over() const { return over_; }
+
+    /*!
+     * \brief Save the whole state of the game: the player, the stars, how far the level's random streams have got,
+     *        the tick count, the camera and whether the game is over
+     *
+     * A real game's worth of stars takes a few microseconds. See Snapshot.h for what snapshots are for.
+     */
+    void save(SnapshotWriter &w) const;
+
+    /*!
+     * \brief Go back to a state written by save()
+     * \return false if the snapshot is from another SNAPSHOT_VERSION or a Simulation of another size (which leaves
+     *         the simulation alone), or is cut short (which leaves it reset to the snapshot's seed)
+     */
+    bool restore(SnapshotReader &r);
+
+    /*!
+     * \enum Input
+     * \brief player inputs that affect the simulation
+     */
+    enum class Input : std::uint8_t {
+        Left,  /*!< Player wants to move left */
+        Right, /*!< Player wants to move right */
+        Up,    /*!< Player wants to jump */
+        Still, /*!< Player wants to stop moving */
+    };
+
+    /*!
+     * \brief Apply a player input
+     * \return true if the input resulted in the player jumping
+     */
+    bool handleInput(Input input);
+
+    /// Things that happened during a call to letObjectsInteract() that a front-end may want to react to
+    struct Events {
+        unsigned stars_touched[NUM_STAR_KINDS] = {}; ///< number of stars of each StarKind the player touched
+        bool star_jumped = false;                    ///< true if touching a star made the player jump
+    };
+
+    /*!
+     * All action happens here
+     *
+     * \brief lets objects interact with each other
+     * \param dt - Time elapsed. This is on a timescale where 1.0 corresponds to 41.6667 msec (24 FPS)
+     * \param events - if not nullptr, receives what happened during this step
+     * \return 1 if player has died
+     */
+    int letObjectsInteract(double dt, Events *events = nullptr);
+
+    /*!
+     * \brief Run ticks in which the player can't touch a star or die, skipping the collision tests
+     *
+     * Works out the earliest time the player could die or touch a star (including ones spawned on the way),
+     * and runs the ticks before it with only the bookkeeping: clocks, camera, spawning and despawning. The
+     * simulation ends up exactly where as many letObjectsInteract() calls would have left it, so replays and
+     * scripted runs can jump from event to event. The tick with the event is left to letObjectsInteract().
+     * \param dt as for letObjectsInteract()
+     * \param max_ticks the most ticks to run, e.g. up to the next input
+     * \return the number of ticks run; 0 if something may happen during the next one
+     */
+    std::uint64_t fastForward(double dt, std::uint64_t max_ticks);
+
+    /// Add stars to stars_ until they fill up the screen
+    void addStars();
+
+    const Player &player() const { return *player_; }
+    Player &player() { return *player_; }
+
+    /// All flying objects that the player can hit
+    const StarPool &stars() const { return stars_; }
+
+    /// \return the world y-position at the bottom of the screen; it never goes down
+    double cameraY() const { return camera_y_; }
+
+    /*!
+     * \brief Camera position interpolated between the previous tick and the current tick, for drawing
+     * \param alpha 0.0 = previous tick's position, 1.0 = current position
+     */
+    double lerpCameraY(double alpha) const { return prev_camera_y_ + (camera_y_ - prev_camera_y_) * alpha; }
+
+    unsigned screen_width() const { return screen_width_; }
+    unsigned screen_height() const { return screen_height_; }
+    unsigned stars_per_row() const { return stars_per_row_; }
+
+private:
+    const unsigned screen_width_;
+    const unsigned screen_height_;
+    const unsigned stars_per_row_;
+
+    /// Start a tick: remember where everything was, so that drawing can interpolate between ticks, then move it
+    void beginTick(double dt);
+
+    /*!
+     * \brief Spawn a row of stars 50 y-pixels above y
+     * \param y where the previous row was spawned
+     * \param moving_stars false to only spawn basic stars
+     */
+    void spawnRow(double y, bool moving_stars);
+
+    /// All flying objects that the player can hit
+    StarPool stars_;
+
+    /// The y-position the most recent row of stars was spawned at
+    double last_row_y_ = 0.0;
+
+    /// See cameraY()
+    double camera_y_ = 0.0;
+
+    /// cameraY() at the start of the current tick
+    double prev_camera_y_ = 0.0;
+
+    /// Player instance
+    std::unique_ptr<Player> player_;
+
+    /// Seed for all randomness in this game; see SpawnRng
+    std::uint64_t seed_ = 0;
+
+    /// Number of spawns done by addStars() since the last reset(); each spawn draws from SpawnRng(seed_, index)
+    std::uint64_t spawn_index_ = 0;
+
+    /// Number of ticks simulated since the last reset()
+    std::uint64_t tick_ = 0;
+
+    /// See over()
+    bool over_ = false;
+};
@@ -0,0 +1,86 @@
+/*!
+ * \file Snapshot.h
+ * \brief File containing the reader and writer for flat snapshots of the game state
+ *
+ * \copyright GNU Public License
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+/// Bump whenever what goes into a snapshot changes; restoring refuses snapshots of any other version
+inline constexpr std::uint32_t SNAPSHOT_VERSION = 1;
+
+/// A saved game state; see Simulation::save()
+using Snapshot = std::vector<std::byte>;
+
+/*!
+ * \class SnapshotWriter
+ * \brief Appends plain values to a Snapshot
+ *
+ * Values are copied byte for byte, so they must be trivially copyable, and a snapshot can only be read back by
+ * the same build: it is for rewinding, seeking and branching a game in memory, not for saving it to disk (that is
+ * what replays are for). Reusing a Snapshot reuses its memory, so saving over an old one doesn't allocate.
+ */
+class SnapshotWriter
+{
+public:
+    /// Start writing over out
+    explicit SnapshotWriter(Snapshot &out) : out_(out) { out_.clear(); }
+
+    /// Append v
+    template <typename T>
+    void put(const T &v) { putArray(&v, 1); }
+
+    /// Append n values from v
+    template <typename T>
+    void putArray(const T *v, std::size_t n)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        const std::size_t at = out_.size();
+        out_.resize(at + n * sizeof(T));
+        if (n > 0)
+            std::memcpy(out_.data() + at, v, n * sizeof(T));
+    }
+
+private:
+    Snapshot &out_;
+};
+
+/*!
+ * \class SnapshotReader
+ * \brief Reads back the values a SnapshotWriter wrote, in the same order
+ */
+class SnapshotReader
+{
+public:
+    explicit SnapshotReader(const Snapshot &in) : p_(in.data()), end_(in.data() + in.size()) {}
+
+    /// Read the next value into v. \return false, leaving v alone, if the snapshot ends first
+    template <typename T>
+    bool get(T &v) { return getArray(&v, 1); }
+
+    /// Read the next n values into v. \return false, leaving v alone, if the snapshot ends first
+    template <typename T>
+    bool getArray(T *v, std::size_t n)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        if (std::size_t(end_ - p_) / sizeof(T) < n)
+            return false;
+        if (n > 0)
+            std::memcpy(v, p_, n * sizeof(T));
+        p_ += n * sizeof(T);
+        return true;
+    }
+
+    /// \return true if everything has been read
+    bool atEnd() const { return p_ == end_; }
+
+private:
+    const std::byte *p_;
+    const std::byte *end_;
+};
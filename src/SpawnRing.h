@@ -0,0 +1,265 @@
+/*!
+ * \file SpawnRing.h
+ * \brief File containing the SpawnRing container
+ *
+ * \copyright GNU Public License
+ */
+#pragma once
+
+#include "Snapshot.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*!
+ * \class SpawnRing
+ * \brief A ring buffer of entities that are spawned in order of a key (e.g. their y-position) and mostly despawn
+ *        from the oldest end
+ *
+ * Every entity has a key and one element in each of the columns Ts, stored as parallel arrays. Keys must be
+ * pushed in non-decreasing order, which keeps the ring sorted, so the entities with keys in a range are found
+ * by binary search and then visited as a plain index window.
+ *
+ * Entities are addressed by their sequence number: 0 for the first one ever pushed, 1 for the next one, and so
+ * on. Sequence numbers are never reused, so they stay valid while other entities come and go. Entities that
+ * despawn out of order (e.g. a star the player touched) are marked dead and skipped by forEach(); their slots
+ * are reclaimed once the oldest end of the ring catches up with them. When the ring is full, push() doubles its
+ * capacity; otherwise it never allocates.
+ */
+template <typename Key, typename... Ts>
+class SpawnRing
+{
+public:
+    using Seq = std::uint64_t;
+
+    /// \param capacity initial capacity; rounded up to a power of 2
+    explicit SpawnRing(std::size_t capacity = 16) { reserve(capacity); }
+
+    /// \return the number of live entities
+    std::size_t size() const { return live_; }
+
+    /// \return true if there are no live entities
+    bool empty() const { return live_ == 0; }
+
+    /// \return the number of entities the ring can hold without growing
+    std::size_t capacity() const { return mask_ + 1; }
+
+    /// \return sequence number of the oldest entity; this one is always alive unless the ring is empty
+    Seq first() const { return head_; }
+
+    /// \return one past the sequence number of the newest entity
+    Seq last() const { return tail_; }
+
+    /// Remove all entities; keeps the memory for reuse. Sequence numbers are not reused.
+    void clear()
+    {
+        head_ = tail_;
+        live_ = 0;
+    }
+
+    /// Make room for n entities
+    void reserve(std::size_t n)
+    {
+        std::size_t cap = 1;
+        while (cap < n) cap *= 2;
+        if (cap > capacity() || alive_.empty())
+            regrow(cap);
+    }
+
+    /*!
+     * \brief Add an entity at the newest end
+     * \param key must not be less than the key of the newest entity
+     * \return the new entity's sequence number
+     */
+    Seq push(Key key, Ts... values)
+    {
+        assert(head_ == tail_ || !(key < this->key(tail_ - 1)));
+        if (tail_ - head_ == capacity())
+            regrow(capacity() * 2);
+        const std::size_t i = slot(tail_);
+        keys_[i] = key;
+        std::apply([&](auto &...col) { ((col[i] = std::move(values)), ...); }, columns_);
+        alive_[i] = true;
+        ++live_;
+        return tail_++;
+    }
+
+    /// Despawn entity s; a no-op if it is already dead
+    void erase(Seq s)
+    {
+        assert(s >= head_ && s < tail_);
+        if (!alive_[slot(s)]) return;
+        alive_[slot(s)] = false;
+        --live_;
+        while (head_ != tail_ && !alive_[slot(head_)]) ++head_;
+    }
+
+    /// Despawn the oldest entity
+    void pop() { erase(head_); }
+
+    /// Despawn every entity from s on, so that the next push() gets sequence number s again (or first(), if later)
+    void truncate(Seq s)
+    {
+        for (s = std::max(s, head_); tail_ > s; --tail_)
+            live_ -= alive_[slot(tail_ - 1)];
+    }
+
+    /// \return true if s is a live entity
+    bool alive(Seq s) const { return s >= head_ && s < tail_ && alive_[slot(s)]; }
+
+    /// \return entity s's key. Dead entities within [first(), last()) keep theirs, so the order is never broken.
+    const Key &key(Seq s) const { return keys_[slot(s)]; }
+
+    /// \return entity s's element of column I
+    template <std::size_t I>
+    auto &get(Seq s) { return std::get<I>(columns_)[slot(s)]; }
+
+    /// \return entity s's element of column I
+    template <std::size_t I>
+    const auto &get(Seq s) const { return std::get<I>(columns_)[slot(s)]; }
+
+    /// \return the first sequence number in [first(), last()) whose key is not less than k, or last()
+    Seq lowerBound(const Key &k) const
+    {
+        Seq lo = head_, hi = tail_;
+        while (lo < hi) {
+            const Seq mid = lo + (hi - lo) / 2;
+            if (key(mid) < k) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    /// \return the first sequence number in [first(), last()) whose key is greater than k, or last()
+    Seq upperBound(const Key &k) const
+    {
+        Seq lo = head_, hi = tail_;
+        while (lo < hi) {
+            const Seq mid = lo + (hi - lo) / 2;
+            if (k < key(mid)) hi = mid;
+            else lo = mid + 1;
+        }
+        return lo;
+    }
+
+    /// \return the window [begin, end) of sequence numbers whose keys are in [lo, hi]
+    std::pair<Seq, Seq> window(const Key &lo, const Key &hi) const { return {lowerBound(lo), upperBound(hi)}; }
+
+    /// Call f(s) for every live entity s in [from, to), oldest first
+    template <typename F>
+    void forEach(Seq from, Seq to, F &&f) const
+    {
+        for (Seq s = std::max(from, head_), end = std::min(to, tail_); s < end; ++s)
+            if (alive_[slot(s)]) f(s);
+    }
+
+    /// Call f(s) for every live entity s, oldest first
+    template <typename F>
+    void forEach(F &&f) const { forEach(head_, tail_, std::forward<F>(f)); }
+
+    /*!
+     * \brief Split [from, to) into runs of consecutive slots, for loops that work on the columns directly
+     *
+     * Calls f(s, i, n) for each run (at most two, as the ring wraps around at most once), where s is the
+     * sequence number of the run's first entity, which lives at index i of keys() and every column, and n is
+     * the run's length. Runs include dead entities.
+     */
+    template <typename F>
+    void forEachRun(Seq from, Seq to, F &&f) const
+    {
+        from = std::max(from, head_);
+        to = std::min(to, tail_);
+        while (from < to) {
+            const std::size_t i = slot(from), n = std::size_t(std::min<Seq>(to - from, capacity() - i));
+            f(from, i, n);
+            from += n;
+        }
+    }
+
+    /// Like forEachRun(from, to, f), for every entity
+    template <typename F>
+    void forEachRun(F &&f) const { forEachRun(head_, tail_, std::forward<F>(f)); }
+
+    /// Append every entity, dead ones in [first(), last()) included, and the sequence numbers to w
+    void save(SnapshotWriter &w) const
+    {
+        w.put(head_);
+        w.put(tail_);
+        w.put(live_);
+        forEachRun([&](Seq, std::size_t i, std::size_t n) {
+            w.putArray(keys_.data() + i, n);
+            std::apply([&](const auto &...col) { (w.putArray(col.data() + i, n), ...); }, columns_);
+            w.putArray(alive_.data() + i, n);
+        });
+    }
+
+    /// Replace everything with what save() wrote, sequence numbers included. \return false, leaving the ring empty,
+    /// if r ends first
+    bool restore(SnapshotReader &r)
+    {
+        Seq head = 0, tail = 0;
+        std::size_t live = 0;
+        if (!r.get(head) || !r.get(tail) || !r.get(live) || tail < head) {
+            clear();
+            return false;
+        }
+        reserve(std::size_t(tail - head));
+        head_ = head;
+        tail_ = tail;
+        live_ = live;
+        bool ok = true;
+        forEachRun([&](Seq, std::size_t i, std::size_t n) {
+            ok = ok && r.getArray(keys_.data() + i, n);
+            std::apply([&](auto &...col) { ((ok = ok && r.getArray(col.data() + i, n)), ...); }, columns_);
+            ok = ok && r.getArray(alive_.data() + i, n);
+        });
+        if (!ok)
+            clear();
+        return ok;
+    }
+
+    /// \return the keys, indexed by slot; see forEachRun()
+    Key *keys() { return keys_.data(); }
+    const Key *keys() const { return keys_.data(); }
+
+    /// \return column I, indexed by slot; see forEachRun()
+    template <std::size_t I>
+    auto *column() { return std::get<I>(columns_).data(); }
+
+    /// \return column I, indexed by slot; see forEachRun()
+    template <std::size_t I>
+    const auto *column() const { return std::get<I>(columns_).data(); }
+
+private:
+    std::size_t slot(Seq s) const { return std::size_t(s) & mask_; }
+
+    /// Move everything into arrays of new_capacity (a power of 2) elements
+    void regrow(std::size_t new_capacity)
+    {
+        const std::size_t new_mask = new_capacity - 1;
+        auto move = [&](auto &col) {
+            std::remove_reference_t<decltype(col)> moved(new_capacity);
+            for (Seq s = head_; s < tail_; ++s)
+                moved[std::size_t(s) & new_mask] = std::move(col[slot(s)]);
+            col.swap(moved);
+        };
+        move(keys_);
+        std::apply([&](auto &...col) { (move(col), ...); }, columns_);
+        move(alive_);
+        mask_ = new_mask;
+    }
+
+    std::vector<Key> keys_;
+    std::tuple<std::vector<Ts>...> columns_;
+    std::vector<std::uint8_t> alive_; ///< not vector<bool>, which is slow to index
+    Seq head_ = 0;
+    Seq tail_ = 0;
+    std::size_t live_ = 0;
+    std::size_t mask_ = 0;
+};
@@ -15,7 +15,7 @@
 #include <cmath>
 
 Sprite::Sprite(const std::string &filename, short x, short y, unsigned short width, unsigned short height, short num_images)
-    : num_images_(num_images), x_(x), y_(y), initial_y_(y_), width_(width), height_(height),
+    : num_images_(num_images), x_(x), y_(y), prev_x_(x_), prev_y_(y_), width_(width), height_(height),
       filename_(filename)
 {}
 
@@ -23,9 +23,9 @@ Sprite::~Sprite() {}
 
 const std::string &Sprite::filename() const { return this->filename_; }
 
-short Sprite::x() const { return this->x_; }
+double Sprite::x() const { return this->x_; }
 
-short Sprite::y() const { return this->y_; }
+double Sprite::y() const { return this->y_; }
 
 unsigned short Sprite::width() const { return this->width_; }
 
@@ -46,7 +46,7 @@ void Sprite::incrTicksElapsed(double dt)
     ticks_elapsed_ += dt * PHYSICS_RATE;
 }
 
-short Sprite::imageX()
+short Sprite::imageX() const
 {
     if (this->num_images_ > 1)
         return getRoundedCumImageIndex() * this->width_;
@@ -54,10 +54,12 @@ short Sprite::imageX()
         return 0;
 }
 
-short Sprite::initialY() const { return this->initial_y_; }
-
-void Sprite::modifyY(int mod)
+void Sprite::beginTick()
 {
-    this->y_ += mod;
-    this->initial_y_ += mod;
+    this->prev_x_ = this->x_;
+    this->prev_y_ = this->y_;
 }
+
+double Sprite::lerpX(double alpha) const { return this->prev_x_ + (this->x_ - this->prev_x_) * alpha; }
+
+double Sprite::lerpY(double alpha) const { return this->prev_y_ + (this->y_ - this->prev_y_) * alpha; }
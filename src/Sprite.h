@@ -10,6 +10,8 @@
  */
 #pragma once
 
+#include "Common.h"
+
 #include <string>
 
 /*!
@@ -33,7 +35,7 @@ public:
     /// Destructor
     virtual ~Sprite();
 
-    /// May be called every frame to animate or otherwise have the sprite do something (Player and BasicStar reimplement)
+    /// May be called every frame to animate or otherwise have the sprite do something (Player reimplements)
     /// Default implementation just increments current_image_ whenever cumulative dt exceeds 1.0.
     virtual void takeAction(double dt);
 
@@ -42,15 +44,27 @@ public:
      */
     const std::string &filename() const;
 
+    /// \return the id GraphicsEngine loaded filename() as; NO_IMAGE until setImage() is called
+    ImageId image() const { return image_; }
+
+    /// Remember what GraphicsEngine::loadImage() returned for filename(), to draw the sprite with
+    void setImage(ImageId image) { image_ = image; }
+
     /*!
-     * \return Sprite's position of the x-axis
+     * \return Sprite's position of the x-axis, in world coordinates
      */
-    short x() const;
+    double x() const;
 
     /*!
-     * \return Sprite's position of the y-axis
+     * \return Sprite's position of the y-axis, in world coordinates
      */
-    short y() const;
+    double y() const;
+
+    /// \return x() at the start of the current tick
+    double prevX() const { return prev_x_; }
+
+    /// \return y() at the start of the current tick
+    double prevY() const { return prev_y_; }
 
     /*!
      * \return Sprite's image's width
@@ -65,18 +79,19 @@ public:
     /*!
      * \return x of the image the Sprite wants to draw
      */
-    virtual short imageX();
+    virtual short imageX() const;
 
-    /*!
-     * \brief the position of the y-axis this sprite was initiated at
-     */
-    short initialY() const;
+    /// Remember the current position as the "previous" position. Called once at the start of every simulation tick.
+    void beginTick();
 
     /*!
-     * \brief Modifies the Sprite's position of the y-axis
-     * \param mod Y axis modifier
+     * \brief Position interpolated between the previous tick and the current tick, for drawing
+     * \param alpha 0.0 = previous tick's position, 1.0 = current position
      */
-    void modifyY(int mod);
+    double lerpX(double alpha) const;
+
+    /// Like lerpX(), but for the y-axis
+    double lerpY(double alpha) const;
 
 protected:
     short getRoundedCumImageIndex() const;
@@ -87,9 +102,11 @@ protected:
     short num_images_;            /*!< How many images a Sprite has */
     double x_;                    /*!< Sprite's position on the x-axis */
     double y_;                    /*!< Sprite's position on the y-acis */
-    short initial_y_;             /*! Sprite's original position on the y-axis */
+    double prev_x_;               /*!< Sprite's x position at the start of the current tick */
+    double prev_y_;               /*!< Sprite's y position at the start of the current tick */
     const unsigned short width_;  /*!< Sprite's image's width */
     const unsigned short height_; /*!< Sprite's image's height */
     std::string filename_;        /*!< Sprite's image's filename */
-    unsigned ticks_elapsed_ = 0;  /*!< Total number of ticks accumulated as a result of calling takeAction() */
+    ImageId image_ = NO_IMAGE;    /*!< Sprite's image, once it is loaded */
+    double ticks_elapsed_ = 0.0;  /*!< Total number of msec accumulated as a result of calling takeAction() */
 };
@@ -0,0 +1,197 @@
+/*!
+ * \file StarKernels.cpp
+ * \brief File containing the StarKernels source code
+ *
+ * \copyright GNU Public License
+ */
+#include "StarKernels.h"
+
+#include <algorithm>
+#include <bit>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#  define STAR_KERNELS_AVX2 1
+#  include <immintrin.h>
+#endif
+#if defined(__SSE2__) || defined(_M_X64)
+#  define STAR_KERNELS_SSE2 1
+#  include <emmintrin.h>
+#endif
+#if defined(__wasm_simd128__)
+#  define STAR_KERNELS_SIMD128 1
+#  include <wasm_simd128.h>
+#endif
+
+namespace {
+
+using Box = StarKernels::Box;
+using Isa = StarKernels::Isa;
+
+struct Kernels {
+    Isa isa;
+    std::size_t (*overlap)(const double *, const double *, std::size_t, const Box &, std::uint64_t *);
+};
+
+/*!
+ * Fills the hits bitmask 64 stars at a time, asking bits(i) for the mask of the stars in [i, i + Width), which
+ * is the inner loop of each vector implementation of overlap(). Width must divide 64.
+ */
+template <std::size_t Width, typename Bits>
+std::size_t fillHits(const double *xs, const double *ys, std::size_t n, const Box &box, std::uint64_t *hits,
+                     Bits &&bits)
+{
+    std::size_t count = 0;
+    for (std::size_t base = 0; base < n; base += 64) {
+        const std::size_t end = std::min(n, base + 64);
+        std::uint64_t word = 0;
+        std::size_t i = base;
+        for (; i + Width <= end; i += Width)
+            word |= std::uint64_t(bits(i)) << (i - base);
+        for (; i < end; ++i)
+            word |= std::uint64_t(StarKernels::inBox(xs[i], ys[i], box)) << (i - base);
+        hits[base / 64] = word;
+        count += std::popcount(word);
+    }
+    return count;
+}
+
+std::size_t overlapScalar(const double *xs, const double *ys, std::size_t n, const Box &box, std::uint64_t *hits)
+{
+    return fillHits<1>(xs, ys, n, box, hits,
+                       [&](std::size_t i) { return unsigned(StarKernels::inBox(xs[i], ys[i], box)); });
+}
+
+constexpr Kernels SCALAR = {Isa::Scalar, overlapScalar};
+
+#ifdef STAR_KERNELS_SSE2
+std::size_t overlapSSE2(const double *xs, const double *ys, std::size_t n, const Box &box, std::uint64_t *hits)
+{
+    const __m128d bx = _mm_set1_pd(box.x), by = _mm_set1_pd(box.y);
+    const __m128d hw = _mm_set1_pd(box.half_w), hh = _mm_set1_pd(box.half_h);
+    const __m128d sign = _mm_set1_pd(-0.0);
+    return fillHits<2>(xs, ys, n, box, hits, [&](std::size_t i) {
+        const __m128d dx = _mm_andnot_pd(sign, _mm_sub_pd(bx, _mm_loadu_pd(xs + i)));
+        const __m128d dy = _mm_andnot_pd(sign, _mm_sub_pd(by, _mm_loadu_pd(ys + i)));
+        return unsigned(_mm_movemask_pd(_mm_and_pd(_mm_cmplt_pd(dx, hw), _mm_cmplt_pd(dy, hh))));
+    });
+}
+
+constexpr Kernels SSE2 = {Isa::SSE2, overlapSSE2};
+#endif
+
+#ifdef STAR_KERNELS_AVX2
+// the same loop as fillHits(), which can't be used here: lambdas don't inherit the target attribute
+__attribute__((target("avx2")))
+std::size_t overlapAVX2(const double *xs, const double *ys, std::size_t n, const Box &box, std::uint64_t *hits)
+{
+    const __m256d bx = _mm256_set1_pd(box.x), by = _mm256_set1_pd(box.y);
+    const __m256d hw = _mm256_set1_pd(box.half_w), hh = _mm256_set1_pd(box.half_h);
+    const __m256d sign = _mm256_set1_pd(-0.0);
+    std::size_t count = 0;
+    for (std::size_t base = 0; base < n; base += 64) {
+        const std::size_t end = std::min(n, base + 64);
+        std::uint64_t word = 0;
+        std::size_t i = base;
+        for (; i + 4 <= end; i += 4) {
+            const __m256d dx = _mm256_andnot_pd(sign, _mm256_sub_pd(bx, _mm256_loadu_pd(xs + i)));
+            const __m256d dy = _mm256_andnot_pd(sign, _mm256_sub_pd(by, _mm256_loadu_pd(ys + i)));
+            const __m256d in = _mm256_and_pd(_mm256_cmp_pd(dx, hw, _CMP_LT_OQ), _mm256_cmp_pd(dy, hh, _CMP_LT_OQ));
+            word |= std::uint64_t(_mm256_movemask_pd(in)) << (i - base);
+        }
+        for (; i < end; ++i)
+            word |= std::uint64_t(StarKernels::inBox(xs[i], ys[i], box)) << (i - base);
+        hits[base / 64] = word;
+        count += std::popcount(word);
+    }
+    return count;
+}
+
+constexpr Kernels AVX2 = {Isa::AVX2, overlapAVX2};
+#endif
+
+#ifdef STAR_KERNELS_SIMD128
+std::size_t overlapSIMD128(const double *xs, const double *ys, std::size_t n, const Box &box, std::uint64_t *hits)
+{
+    const v128_t bx = wasm_f64x2_splat(box.x), by = wasm_f64x2_splat(box.y);
+    const v128_t hw = wasm_f64x2_splat(box.half_w), hh = wasm_f64x2_splat(box.half_h);
+    return fillHits<2>(xs, ys, n, box, hits, [&](std::size_t i) {
+        const v128_t dx = wasm_f64x2_abs(wasm_f64x2_sub(bx, wasm_v128_load(xs + i)));
+        const v128_t dy = wasm_f64x2_abs(wasm_f64x2_sub(by, wasm_v128_load(ys + i)));
+        return unsigned(wasm_i64x2_bitmask(wasm_v128_and(wasm_f64x2_lt(dx, hw), wasm_f64x2_lt(dy, hh))));
+    });
+}
+
+constexpr Kernels SIMD128 = {Isa::SIMD128, overlapSIMD128};
+#endif
+
+/// \return the kernels for isa, or nullptr if this build doesn't have them
+const Kernels *kernelsFor(Isa isa)
+{
+    switch (isa) {
+    case Isa::Scalar:
+        return &SCALAR;
+    case Isa::SSE2:
+#ifdef STAR_KERNELS_SSE2
+        return &SSE2;
+#else
+        return nullptr;
+#endif
+    case Isa::AVX2:
+#ifdef STAR_KERNELS_AVX2
+        return __builtin_cpu_supports("avx2") ? &AVX2 : nullptr;
+#else
+        return nullptr;
+#endif
+    case Isa::SIMD128:
+#ifdef STAR_KERNELS_SIMD128
+        return &SIMD128;
+#else
+        return nullptr;
+#endif
+    }
+    return nullptr;
+}
+
+const Kernels *&current()
+{
+    static const Kernels *kernels = [] {
+        for (Isa isa : {Isa::AVX2, Isa::SSE2, Isa::SIMD128})
+            if (const Kernels *k = kernelsFor(isa)) return k;
+        return &SCALAR;
+    }();
+    return kernels;
+}
+
+} // namespace
+
+StarKernels::Isa StarKernels::isa() { return current()->isa; }
+
+bool StarKernels::supported(Isa isa) { return kernelsFor(isa) != nullptr; }
+
+bool StarKernels::select(Isa isa)
+{
+    const Kernels *k = kernelsFor(isa);
+    if (k) current() = k;
+    return k != nullptr;
+}
+
+const char *StarKernels::name(Isa isa)
+{
+    switch (isa) {
+    case Isa::Scalar:
+        return "scalar";
+    case Isa::SSE2:
+        return "sse2";
+    case Isa::AVX2:
+        return "avx2";
+    case Isa::SIMD128:
+        return "simd128";
+    }
+    return "?";
+}
+
+std::size_t StarKernels::overlap(const double *xs, const double *ys, std::size_t n, const Box &box,
+                                 std::uint64_t *hits)
+{
+    return current()->overlap(xs, ys, n, box, hits);
+}
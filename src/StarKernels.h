@@ -0,0 +1,65 @@
+/*!
+ * \file StarKernels.h
+ * \brief File containing the vectorized loops that test stars against the player
+ *
+ * \copyright GNU Public License
+ */
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+/*!
+ * \class StarKernels
+ * \brief Static interface to the SIMD kernels that run over StarPool's columns
+ *
+ * Every kernel has a scalar version plus SSE2 and AVX2 versions on x86 (picked at runtime according to what
+ * the CPU supports) and a SIMD128 version for WebAssembly builds with -msimd128. All versions do the same
+ * IEEE double operations in the same order, without fused multiply-adds, so they produce bit-identical results
+ * and replays don't depend on which one ran.
+ */
+class StarKernels
+{
+public:
+    /// Instruction sets a kernel can be built for
+    enum class Isa { Scalar, SSE2, AVX2, SIMD128 };
+
+    /*!
+     * \struct Box
+     * \brief The area around the player that a star must be in to touch it
+     *
+     * Star i is in the box if |x - xs[i]| < half_w and |y - ys[i]| < half_h.
+     */
+    struct Box {
+        double x;
+        double y;
+        double half_w;
+        double half_h;
+    };
+
+    /// \return the instruction set the kernels currently use; the best one the CPU supports unless select() was called
+    static Isa isa();
+
+    /// \return true if this build and CPU can run kernels for isa
+    static bool supported(Isa isa);
+
+    /// Use isa from now on (e.g. to compare against the scalar kernels). Not thread safe. \return false if unsupported
+    static bool select(Isa isa);
+
+    /// \return printable name of isa
+    static const char *name(Isa isa);
+
+    /// \return true if a star at (x, y) is in box; what overlap() computes for one star
+    static bool inBox(double x, double y, const Box &box)
+    {
+        return std::abs(box.x - x) < box.half_w && std::abs(box.y - y) < box.half_h;
+    }
+
+    /*!
+     * \brief Test stars [0, n) against box
+     * \param hits receives (n + 63) / 64 words; bit i % 64 of word i / 64 is set if star i is in the box
+     * \return the number of stars in the box
+     */
+    static std::size_t overlap(const double *xs, const double *ys, std::size_t n, const Box &box, std::uint64_t *hits);
+};
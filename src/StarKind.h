@@ -0,0 +1,74 @@
+/*!
+ * \file StarKind.h
+ * \brief File containing the star kinds and the table describing how each of them behaves
+ *
+ * \copyright GNU Public License
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+/*!
+ * \enum StarKind
+ * \brief The types of star the player can hit; an index into STAR_BEHAVIOURS
+ */
+enum class StarKind : std::uint8_t {
+    Basic,  /*!< The most basic type of star, cannot move */
+    Moving, /*!< A basic star which moves around */
+};
+
+/// Number of star effects AudioEngine can play; bit i of StarBehaviour::sounds is AudioEngine::playStarSound(i)
+inline constexpr unsigned NUM_STAR_SOUNDS = 2;
+
+/*!
+ * \struct StarBehaviour
+ * \brief Everything that differs between kinds of star
+ *
+ * To add a kind of star, add it to StarKind and give it a row in STAR_BEHAVIOURS; the simulation and drawing
+ * code only ever look stars up in this table.
+ */
+struct StarBehaviour {
+    const char *filename;  ///< name of the image file inside graphics/
+    unsigned short width;  ///< width of one frame of the image
+    unsigned short height; ///< height of the image
+    short num_images;      ///< number of animation frames in the image
+    int push_level;        ///< force_push_level passed to Player::jump() when the player touches the star
+    std::uint8_t sounds;   ///< bitmask of the star sounds played when the player touches the star
+    bool moves;            ///< true if stars of this kind are spawned with a velocity
+    int max_speed;         ///< moving stars are spawned with dx and dy in [-max_speed, max_speed]
+};
+
+/// How each StarKind behaves, in StarKind order
+inline constexpr StarBehaviour STAR_BEHAVIOURS[] = {
+    /* StarKind::Basic  */ {"basic_star", 20, 20, 4, 1, 0b01, false, 0},
+    /* StarKind::Moving */ {"moving_star", 20, 20, 4, 2, 0b11, true, 5},
+};
+
+/// Number of kinds of star
+inline constexpr std::size_t NUM_STAR_KINDS = std::size(STAR_BEHAVIOURS);
+
+/// The width of the widest kind of star
+inline constexpr unsigned short MAX_STAR_WIDTH = [] {
+    unsigned short w = 0;
+    for (const StarBehaviour &b : STAR_BEHAVIOURS) w = b.width > w ? b.width : w;
+    return w;
+}();
+
+/// The height of the tallest kind of star
+inline constexpr unsigned short MAX_STAR_HEIGHT = [] {
+    unsigned short h = 0;
+    for (const StarBehaviour &b : STAR_BEHAVIOURS) h = b.height > h ? b.height : h;
+    return h;
+}();
+
+/// The fastest any kind of star moves along either axis, per unit of dt
+inline constexpr int MAX_STAR_SPEED = [] {
+    int v = 0;
+    for (const StarBehaviour &b : STAR_BEHAVIOURS) v = b.max_speed > v ? b.max_speed : v;
+    return v;
+}();
+
+/// \return how stars of this kind behave
+constexpr const StarBehaviour &behaviour(StarKind kind) { return STAR_BEHAVIOURS[std::size_t(kind)]; }
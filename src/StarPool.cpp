@@ -0,0 +1,178 @@
+/*!
+ * \file StarPool.cpp
+ * \brief File containing the StarPool class source code
+ *
+ * \copyright GNU Public License
+ */
+#include "StarPool.h"
+
+#include <cmath>
+#include <functional>
+
+short StarPool::Star::imageX() const
+{
+    const StarBehaviour &b = behaviour(kind);
+    if (b.num_images > 1)
+        return (int(std::round(anim)) % b.num_images) * b.width;
+    else
+        return 0;
+}
+
+void StarPool::clear()
+{
+    still_.clear();
+    movers_.clear();
+    now_ = prev_now_ = 0.0;
+    std::fill(bucket_heads_.begin(), bucket_heads_.end(), NO_STAR);
+    min_bucket_ = INT64_MAX;
+    crossings_.clear();
+}
+
+void StarPool::reserve(std::size_t n)
+{
+    still_.reserve(n);
+    movers_.reserve(n);
+    crossings_.reserve(n);
+    hits_.reserve((n + 63) / 64);
+}
+
+void StarPool::spawn(StarKind kind, double x, double y, double dx, double dy)
+{
+    if (behaviour(kind).moves) {
+        const Seq s = movers_.push(y, x, dx, dy, now_, kind, 0, NO_STAR, NO_STAR);
+        link(s, bucketOf(y));
+        scheduleCrossing(s);
+    } else
+        still_.push(y, x, now_, kind);
+}
+
+void StarPool::takeAction(double dt)
+{
+    prev_now_ = now_;
+    now_ += dt;
+    // Move each star whose crossing time has come one bucket on. Rounding can put a star's crossing a hair
+    // after the tick that takes it across, so a star within a pixel of a boundary may still be in the bucket
+    // it is leaving; removeIf() and despawnBelow() allow for that.
+    while (!crossings_.empty() && crossings_.front().first <= now_) {
+        std::pop_heap(crossings_.begin(), crossings_.end(), std::greater<>());
+        const Seq s = crossings_.back().second;
+        crossings_.pop_back();
+        if (!movers_.alive(s)) continue;
+        const std::int64_t b = movers_.get<M_BUCKET>(s) + (movers_.get<M_DY>(s) > 0.0 ? 1 : -1);
+        unlink(s);
+        link(s, b);
+        scheduleCrossing(s);
+    }
+}
+
+void StarPool::despawnBelow(double y)
+{
+    // still_ is sorted on y, so everything that fell off is at the oldest end
+    while (!still_.empty() && still_.key(still_.first()) < y)
+        still_.pop();
+    // everything that fell off was despawned last time, so only look at the buckets stars moved into since
+    forEachMover(min_bucket_, bucketOf(y + 1), [&](Seq s) {
+        if (moverY(s, now_) < y)
+            eraseMover(s);
+    });
+    min_bucket_ = std::max(min_bucket_, bucketOf(y - 1));
+}
+
+void StarPool::save(SnapshotWriter &w) const
+{
+    // everything goes in as it is, sequence numbers and the order of the bucket lists and the heap included:
+    // stars touched in the same tick are visited in that order, and the order they push the player in can
+    // change how its speed rounds
+    w.put(now_);
+    w.put(prev_now_);
+    w.put(min_bucket_);
+    w.putArray(bucket_heads_.data(), bucket_heads_.size());
+    w.put(std::uint64_t(crossings_.size()));
+    for (const auto &[time, s] : crossings_) {
+        w.put(time);
+        w.put(s);
+    }
+    still_.save(w);
+    movers_.save(w);
+}
+
+bool StarPool::restore(SnapshotReader &r)
+{
+    clear();
+    std::uint64_t n = 0;
+    bool ok = r.get(now_) && r.get(prev_now_) && r.get(min_bucket_) &&
+              r.getArray(bucket_heads_.data(), bucket_heads_.size()) && r.get(n);
+    for (std::pair<double, Seq> c; ok && n > 0; --n) {
+        ok = r.get(c.first) && r.get(c.second);
+        crossings_.push_back(c);
+    }
+    ok = ok && still_.restore(r) && movers_.restore(r);
+    if (!ok)
+        clear();
+    return ok;
+}
+
+void StarPool::link(Seq s, std::int64_t b)
+{
+    Seq &head = bucket_heads_[std::uint64_t(b) % NUM_BUCKETS];
+    movers_.get<M_BUCKET>(s) = b;
+    movers_.get<M_PREV>(s) = NO_STAR;
+    movers_.get<M_NEXT>(s) = head;
+    if (head != NO_STAR)
+        movers_.get<M_PREV>(head) = s;
+    head = s;
+    min_bucket_ = std::min(min_bucket_, b);
+}
+
+void StarPool::unlink(Seq s)
+{
+    const Seq prev = movers_.get<M_PREV>(s), next = movers_.get<M_NEXT>(s);
+    if (prev != NO_STAR)
+        movers_.get<M_NEXT>(prev) = next;
+    else
+        bucket_heads_[std::uint64_t(movers_.get<M_BUCKET>(s)) % NUM_BUCKETS] = next;
+    if (next != NO_STAR)
+        movers_.get<M_PREV>(next) = prev;
+}
+
+void StarPool::eraseMover(Seq s)
+{
+    unlink(s);
+    movers_.erase(s);
+}
+
+void StarPool::scheduleCrossing(Seq s)
+{
+    const double dy = movers_.get<M_DY>(s);
+    if (dy == 0.0) return;
+    // the edge of the bucket the star is heading for
+    const std::int64_t b = movers_.get<M_BUCKET>(s);
+    const double edge = double(dy > 0.0 ? b + 1 : b) * BUCKET_HEIGHT;
+    crossings_.emplace_back(movers_.get<M_SPAWN_TIME>(s) + (edge - movers_.key(s)) / dy, s);
+    std::push_heap(crossings_.begin(), crossings_.end(), std::greater<>());
+}
+
+double StarPool::anim(StarKind kind, double spawn_time) const
+{
+    return std::fmod(std::max(now_ - spawn_time, 0.0), behaviour(kind).num_images);
+}
+
+auto StarPool::stillStar(Seq s) const -> Star
+{
+    const double x = still_.get<S_X>(s), y = still_.key(s);
+    const StarKind kind = still_.get<S_KIND>(s);
+    return {kind, x, y, x, y, 0.0, 0.0, anim(kind, still_.get<S_SPAWN_TIME>(s))};
+}
+
+auto StarPool::moverStar(Seq s) const -> Star
+{
+    const StarKind kind = movers_.get<M_KIND>(s);
+    return {kind,
+            moverX(s, now_),
+            moverY(s, now_),
+            moverX(s, prev_now_),
+            moverY(s, prev_now_),
+            movers_.get<M_DX>(s),
+            movers_.get<M_DY>(s),
+            anim(kind, movers_.get<M_SPAWN_TIME>(s))};
+}
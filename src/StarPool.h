@@ -0,0 +1,267 @@
+/*!
+ * \file StarPool.h
+ * \brief File containing the StarPool class Header
+ *
+ * \copyright GNU Public License
+ */
+#pragma once
+
+#include "Snapshot.h"
+#include "SpawnRing.h"
+#include "StarKernels.h"
+#include "StarKind.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+/*!
+ * \class StarPool
+ * \brief All the stars in a Simulation, stored as parallel arrays in two SpawnRings
+ *
+ * Stars are spawned row by row, bottom to top, so a ring keyed on y keeps them sorted for free. Stars that
+ * don't move stay sorted forever: finding the ones near the player, or the ones that fell off the bottom of
+ * the screen, is a binary search plus an index window. Moving stars drift away from the row they were spawned
+ * in, so they get a ring of their own (keyed on their spawn row) plus a broadphase index: a table of buckets,
+ * each holding a linked list of the moving stars in one BUCKET_HEIGHT-pixel band of y.
+ *
+ * Nothing stored about a star changes after it spawns. Its position and animation phase are functions of the
+ * time since it spawned, worked out only when something asks for them: drawing, collision candidates and
+ * despawning. A tick therefore costs nothing for most stars. The exception is a moving star crossing into
+ * another bucket; the time of each one's next crossing is kept in a min-heap, so only those stars are touched.
+ *
+ * Positions are in world coordinates, which don't change when the screen scrolls (see Simulation::cameraY()).
+ *
+ * Once the pool has seen its busiest screen, spawning and despawning stars never allocates.
+ */
+class StarPool
+{
+public:
+    /// A copy of one star's state, as handed out by forEach() and removeIf()
+    struct Star {
+        StarKind kind;
+        double x;      ///< position on the x-axis, in world coordinates
+        double y;      ///< position on the y-axis, in world coordinates
+        double prev_x; ///< x position at the start of the current tick
+        double prev_y; ///< y position at the start of the current tick
+        double dx;     ///< x-axis movement per unit of dt
+        double dy;     ///< y-axis movement per unit of dt
+        double anim;   ///< animation phase, in [0, num_images)
+
+        /*!
+         * \brief Position interpolated between the previous tick and the current tick, for drawing
+         * \param alpha 0.0 = previous tick's position, 1.0 = current position
+         */
+        double lerpX(double alpha) const { return prev_x + (x - prev_x) * alpha; }
+
+        /// Like lerpX(), but for the y-axis
+        double lerpY(double alpha) const { return prev_y + (y - prev_y) * alpha; }
+
+        /// \return x of the image the star wants to draw
+        short imageX() const;
+    };
+
+    /// \return the number of stars
+    std::size_t size() const { return still_.size() + movers_.size(); }
+
+    /// \return true if there are no stars
+    bool empty() const { return still_.empty() && movers_.empty(); }
+
+    /// Remove all stars and reset time() to 0; keeps the memory for reuse
+    void clear();
+
+    /// Make room for n stars that don't move and n that do, without allocating
+    void reserve(std::size_t n);
+
+    /// \return the sum of all takeAction() dts since clear()
+    double time() const { return now_; }
+
+    /*!
+     * \brief Add a star at time(). Stars that don't move must be spawned in order of y.
+     * \param kind what kind of star
+     * \param x starting x-position
+     * \param y starting y-position
+     * \param dx x-axis movement per unit of dt; ignored unless the kind moves
+     * \param dy y-axis movement per unit of dt; ignored unless the kind moves
+     */
+    void spawn(StarKind kind, double x, double y, double dx = 0.0, double dy = 0.0);
+
+    /*!
+     * \brief Move and animate all stars, by advancing time() by dt
+     *
+     * Also makes the current positions the "previous" ones. Called once every simulation tick.
+     */
+    void takeAction(double dt);
+
+    /// Remove every star whose y-position is below y
+    void despawnBelow(double y);
+
+    /// \return a y-position that no star will be below at any point during the next t
+    double floorWithin(double t) const
+    {
+        double y = still_.empty() ? std::numeric_limits<double>::infinity() : still_.key(still_.first());
+        if (!movers_.empty()) // a pixel of slack for stars that are just crossing into another bucket
+            y = std::min(y, double(min_bucket_) * BUCKET_HEIGHT - 1.0 - MAX_STAR_SPEED * t);
+        return y;
+    }
+
+    /// Append every star, and time(), to w
+    void save(SnapshotWriter &w) const;
+
+    /// Replace every star, and time(), with what save() wrote. \return false, leaving the pool empty, if r ends first
+    bool restore(SnapshotReader &r);
+
+    /// Call f(const Star &) for every star
+    template <typename F>
+    void forEach(F &&f) const
+    {
+        still_.forEach([&](Seq s) { f(stillStar(s)); });
+        movers_.forEach([&](Seq s) { f(moverStar(s)); });
+    }
+
+    /*!
+     * \brief Call f(const Star &) for every star that may be within [lo, hi] on the y-axis at some point during
+     *        the next t. Includes some stars that won't be.
+     */
+    template <typename F>
+    void forEachNear(double lo, double hi, double t, F &&f) const
+    {
+        const auto [begin, end] = still_.window(lo, hi);
+        still_.forEach(begin, end, [&](Seq s) { f(stillStar(s)); });
+        const double drift = MAX_STAR_SPEED * t + 1.0;
+        forEachMover(bucketOf(lo - drift), bucketOf(hi + drift), [&](Seq s) { f(moverStar(s)); });
+    }
+
+    /*!
+     * \brief Call pred(const Star &) for every star in box and remove the ones it returns true for
+     *
+     * Only the stars in the box are visited, so pred may have side effects. Stars that don't move are tested
+     * with StarKernels::overlap() if they are within box's height; moving stars are tested if they are in a
+     * bucket that overlaps the box.
+     */
+    template <typename Pred>
+    void removeIf(const StarKernels::Box &box, Pred &&pred)
+    {
+        const auto [begin, end] = still_.window(box.y - box.half_h, box.y + box.half_h);
+        still_.forEachRun(begin, end, [&](Seq first, std::size_t i, std::size_t n) {
+            forEachHit(still_.column<S_X>() + i, still_.keys() + i, n, box, [&](std::size_t j) {
+                if (still_.alive(first + j) && pred(stillStar(first + j)))
+                    still_.erase(first + j);
+            });
+        });
+        // a pixel of slack either way, for stars that are just crossing into another bucket; see takeAction()
+        forEachMover(bucketOf(box.y - box.half_h - 1), bucketOf(box.y + box.half_h + 1), [&](Seq s) {
+            if (StarKernels::inBox(moverX(s, now_), moverY(s, now_), box) && pred(moverStar(s)))
+                eraseMover(s);
+        });
+    }
+
+private:
+    using Seq = std::uint64_t;
+
+    /// Stars that don't move; keyed on y
+    enum { S_X, S_SPAWN_TIME, S_KIND };
+    SpawnRing<double, double, double, StarKind> still_;
+
+    /// Stars that move; keyed on the y-position they were spawned at. M_BUCKET, M_NEXT and M_PREV place the
+    /// star in the broadphase index.
+    enum { M_X, M_DX, M_DY, M_SPAWN_TIME, M_KIND, M_BUCKET, M_NEXT, M_PREV };
+    SpawnRing<double, double, double, double, double, StarKind, std::int64_t, Seq, Seq> movers_;
+
+    /// See time()
+    double now_ = 0.0;
+
+    /// time() at the start of the current tick
+    double prev_now_ = 0.0;
+
+    static constexpr double BUCKET_HEIGHT = MAX_STAR_HEIGHT; ///< height of the band of y each bucket covers
+    static constexpr std::size_t NUM_BUCKETS = 256;          ///< bucket b lives at index b % NUM_BUCKETS
+    static constexpr Seq NO_STAR = ~Seq(0);                  ///< end of a bucket's list
+
+    /// First moving star in each bucket, or NO_STAR
+    std::vector<Seq> bucket_heads_ = std::vector<Seq>(NUM_BUCKETS, NO_STAR);
+
+    /// No moving star is in a bucket below this one
+    std::int64_t min_bucket_ = INT64_MAX;
+
+    /// (time, star) of each moving star's next bucket crossing, as a min-heap. Stars erased since stay in the
+    /// heap until their time comes.
+    std::vector<std::pair<double, Seq>> crossings_;
+
+    /// \return the bucket a star at y belongs in
+    static std::int64_t bucketOf(double y)
+    {
+        // floor() without the libm call
+        const double v = y * (1.0 / BUCKET_HEIGHT);
+        const std::int64_t b = std::int64_t(v);
+        return b > v ? b - 1 : b;
+    }
+
+    /// \return moving star s's x-position at time t
+    double moverX(Seq s, double t) const
+    {
+        return movers_.get<M_X>(s) + movers_.get<M_DX>(s) * std::max(t - movers_.get<M_SPAWN_TIME>(s), 0.0);
+    }
+
+    /// \return moving star s's y-position at time t
+    double moverY(Seq s, double t) const
+    {
+        return movers_.key(s) + movers_.get<M_DY>(s) * std::max(t - movers_.get<M_SPAWN_TIME>(s), 0.0);
+    }
+
+    /// Add moving star s to bucket b
+    void link(Seq s, std::int64_t b);
+
+    /// Remove moving star s from its bucket
+    void unlink(Seq s);
+
+    /// Remove moving star s from the pool
+    void eraseMover(Seq s);
+
+    /// Push the time moving star s leaves its bucket onto crossings_, unless it never does
+    void scheduleCrossing(Seq s);
+
+    /// Call f(s) for every moving star s in buckets [b0, b1]; f may erase s
+    template <typename F>
+    void forEachMover(std::int64_t b0, std::int64_t b1, F &&f) const
+    {
+        if (b0 > b1) return;
+        if (std::uint64_t(b1 - b0) >= NUM_BUCKETS) {
+            // the range wraps around the whole table; cheaper to look at every star once
+            for (Seq s = movers_.first(); s < movers_.last(); ++s)
+                if (movers_.alive(s) && movers_.get<M_BUCKET>(s) >= b0 && movers_.get<M_BUCKET>(s) <= b1)
+                    f(s);
+            return;
+        }
+        for (std::int64_t b = b0; b <= b1; ++b)
+            for (Seq s = bucket_heads_[std::uint64_t(b) % NUM_BUCKETS], next; s != NO_STAR; s = next) {
+                next = movers_.get<M_NEXT>(s);
+                if (movers_.get<M_BUCKET>(s) == b) // buckets NUM_BUCKETS apart share a list
+                    f(s);
+            }
+    }
+
+    /// Bitmask of stars in the box, for removeIf()
+    std::vector<std::uint64_t> hits_;
+
+    /// \return the animation phase at time() of a star spawned at spawn_time
+    double anim(StarKind kind, double spawn_time) const;
+
+    Star stillStar(Seq s) const;
+    Star moverStar(Seq s) const;
+
+    /// Call f(j) for each star j in [0, n) that is in box
+    template <typename F>
+    void forEachHit(const double *xs, const double *ys, std::size_t n, const StarKernels::Box &box, F &&f)
+    {
+        hits_.resize((n + 63) / 64);
+        if (StarKernels::overlap(xs, ys, n, box, hits_.data()) == 0) return;
+        for (std::size_t w = 0; w < hits_.size(); ++w)
+            for (std::uint64_t word = hits_[w]; word; word &= word - 1)
+                f(w * 64 + std::countr_zero(word));
+    }
+};
@@ -0,0 +1,553 @@
+/*!
+ * \file bench/main.cpp
+ * \brief Microbenchmarks for the simulation and rendering hot paths
+ *
+ * \copyright GNU Public License
+ *
+ * Usage: jumpman_bench [--stars N,N,...] [--min-time SECS] [--filter SUBSTR] [--out FILE]
+ *                      [--baseline FILE] [--tolerance FRACTION]
+ *
+ * Each benchmark runs at each of the given star counts (default: 15,1000,10000,100000; 15 is about what the real
+ * game has on screen) and reports nanoseconds per operation, and that time as a multiple of a reference workload
+ * (sorting a fixed array) measured in the same run. Results are written as JSON to --out (default: stdout). With
+ * --baseline, results are compared against a previous --out file and the program exits with status 2 if any
+ * benchmark got slower by more than --tolerance (default 0.25, i.e. 25%). The comparison is of the multiples, not
+ * of the times, so that a baseline made on one machine still means something on another.
+ *
+ * StarKernels benchmarks run once per instruction set the CPU supports. Before they run, each instruction
+ * set's results are checked against the scalar kernels; any difference makes the program exit with status 3.
+ *
+ * Rendering benchmarks draw into an offscreen surface and are only built along with the game; they load
+ * graphics/ relative to the current directory, so run from the top of the source tree. They run once with the
+ * surface blitter and once with SDL's software renderer (marked [renderer]), side by side.
+ */
+#define SDL_MAIN_HANDLED
+
+#include "FixedTimestep.h"
+#include "HudText.h"
+#include "Random.h"
+#include "Rewind.h"
+#include "Simulation.h"
+#include "StarKernels.h"
+#ifdef JUMPMAN_BENCH_RENDER
+#include "GraphicsEngine.h"
+#endif
+
+#include "tinyformat.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+constexpr unsigned SCREEN_WIDTH = 1000, SCREEN_HEIGHT = 600;
+constexpr std::uint64_t SEED = 1;
+
+struct Options {
+    std::vector<unsigned> star_counts = {15, 1000, 10000, 100000};
+    double min_time = 0.2;
+    std::string filter;
+    std::string out_file;
+    std::string baseline_file;
+    double tolerance = 0.25;
+};
+
+struct Result {
+    std::string name;
+    std::size_t stars;
+    double ns_per_op;
+    std::uint64_t ops;
+    double relative; ///< ns_per_op as a multiple of the reference's
+};
+
+/// Name of the reference workload's result
+constexpr std::string_view REFERENCE = "reference";
+
+/// Keeps the compiler from optimizing away the work being measured
+volatile std::size_t g_sink;
+
+std::optional<Options> parseArgs(int argc, char **argv)
+{
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool has_val = i + 1 < argc;
+        if (arg == "--stars" && has_val) {
+            opts.star_counts.clear();
+            std::istringstream ss(argv[++i]);
+            for (std::string n; std::getline(ss, n, ',');)
+                opts.star_counts.push_back(std::max(std::atoi(n.c_str()), 1));
+        } else if (arg == "--min-time" && has_val)
+            opts.min_time = std::atof(argv[++i]);
+        else if (arg == "--filter" && has_val)
+            opts.filter = argv[++i];
+        else if (arg == "--out" && has_val)
+            opts.out_file = argv[++i];
+        else if (arg == "--baseline" && has_val)
+            opts.baseline_file = argv[++i];
+        else if (arg == "--tolerance" && has_val)
+            opts.tolerance = std::atof(argv[++i]);
+        else {
+            std::cerr << "Unknown argument: " << arg << "\n"
+                      << "Usage: " << argv[0] << " [--stars N,N,...] [--min-time SECS] [--filter SUBSTR] [--out FILE]"
+                         " [--baseline FILE] [--tolerance FRACTION]\n";
+            return std::nullopt;
+        }
+    }
+    return opts;
+}
+
+/*!
+ * Runs op with growing iteration counts until one run takes a third of min_time, then takes the best of 3 runs.
+ * op(iterations) must return the number of operations it performed.
+ */
+std::pair<double, std::uint64_t> measure(const std::function<std::uint64_t(std::uint64_t)> &op, double min_time)
+{
+    using Clock = std::chrono::steady_clock;
+    auto run = [&](std::uint64_t iters) {
+        const auto t0 = Clock::now();
+        const std::uint64_t ops = op(iters);
+        return std::make_pair(std::chrono::duration<double>(Clock::now() - t0).count(), ops);
+    };
+
+    std::uint64_t iters = 1;
+    for (auto [secs, ops] = run(iters); secs < min_time / 3 && iters < (1ull << 40); std::tie(secs, ops) = run(iters))
+        iters = secs > 0.0 ? std::max(iters * 2, std::uint64_t(iters * (min_time / 3) / secs * 1.2)) : iters * 10;
+
+    double best = 1e300;
+    std::uint64_t total_ops = 0;
+    for (int rep = 0; rep < 3; ++rep) {
+        const auto [secs, ops] = run(iters);
+        best = std::min(best, secs * 1e9 / std::max<std::uint64_t>(ops, 1));
+        total_ops += ops;
+    }
+    return {best, total_ops};
+}
+
+/// The area a player in the middle of the screen can touch stars in
+constexpr StarKernels::Box KERNEL_BOX = {3.5, SCREEN_HEIGHT / 2 + 0.25, 20, 50};
+
+/// A simulation with about n stars on screen
+std::unique_ptr<Simulation> makeSim(unsigned n)
+{
+    // with 1 star per row, a 600 pixel tall screen holds ~13.7 stars (12 rows, 1/7 chance of an extra moving star)
+    const unsigned per_row = std::max(1u, unsigned(std::lround(n / 13.7)));
+    auto sim = std::make_unique<Simulation>(SCREEN_WIDTH, SCREEN_HEIGHT, per_row);
+    sim->reset(SEED);
+    sim->addStars();
+    return sim;
+}
+
+class Bench
+{
+public:
+    explicit Bench(const Options &o) : opts(o)
+    {
+        SpawnRng rng(SEED, 0);
+        for (double &x : reference_input_)
+            x = rng.range(0, 1 << 30);
+        const auto [ns, ops] = measureReference(opts.min_time);
+        results.push_back({std::string(REFERENCE), 0, ns, ops, 1.0});
+        std::cerr << strprintf("%-36s %12.1f ns/op\n", REFERENCE, ns);
+    }
+
+    /*!
+     * The reference is timed again, briefly, just before and after op, and op's time is divided by the faster of
+     * the two: clock speed and noisy neighbours drift during a run, and a multiple of a reference timed minutes
+     * earlier would drift with them.
+     */
+    void add(const std::string &name, std::size_t stars, const std::function<std::uint64_t(std::uint64_t)> &op) {
+        if (!opts.filter.empty() && name.find(opts.filter) == std::string::npos)
+            return;
+        const double ref_before = measureReference(opts.min_time / 4).first;
+        const auto [ns, ops] = measure(op, opts.min_time);
+        const double ref_ns = std::min(ref_before, measureReference(opts.min_time / 4).first);
+        results.push_back({name, stars, ns, ops, ns / ref_ns});
+        std::cerr << strprintf("%-36s %12.1f ns/op %10.4gx ref  (%d stars)\n", name, ns, ns / ref_ns, stars);
+    }
+
+    const Options &opts;
+    std::vector<Result> results;
+
+private:
+    /// What the reference workload sorts
+    std::array<double, 1024> reference_input_;
+
+    /// Time the reference workload, whatever the filter: sorting the same 1024 doubles over and over, which only
+    /// depends on the CPU and the compiler
+    std::pair<double, std::uint64_t> measureReference(double min_time)
+    {
+        std::array<double, 1024> work;
+        return measure([&](std::uint64_t iters) {
+            for (std::uint64_t i = 0; i < iters; ++i) {
+                work = reference_input_;
+                std::sort(work.begin(), work.end());
+            }
+            g_sink = std::size_t(work[0]);
+            return iters;
+        }, min_time);
+    }
+};
+
+void simBenchmarks(Bench &b, unsigned n)
+{
+    const double dt = FixedTimestep(DEFAULT_SIM_RATE).tickDT();
+
+    {
+        auto sim = makeSim(n);
+        b.add(strprintf("letObjectsInteract/%d", n), sim->stars().size(), [&](std::uint64_t iters) {
+            for (std::uint64_t i = 0; i < iters; ++i)
+                if (sim->letObjectsInteract(dt) == 1) {
+                    sim->reset(SEED);
+                    sim->addStars();
+                }
+            return iters;
+        });
+    }
+
+    {
+        auto sim = makeSim(n);
+        b.add(strprintf("addStars/%d", n), sim->stars().size(), [&](std::uint64_t iters) {
+            // refill the screen from scratch
+            for (std::uint64_t i = 0; i < iters; ++i) {
+                sim->reset(SEED + i);
+                sim->addStars();
+            }
+            return iters;
+        });
+    }
+
+    {
+        // one collision query, as each player would make every tick; nothing is removed
+        auto sim = makeSim(n);
+        StarPool pool = sim->stars();
+        b.add(strprintf("StarPool::removeIf/%d", n), pool.size(), [&](std::uint64_t iters) {
+            std::size_t hits = 0;
+            for (std::uint64_t i = 0; i < iters; ++i)
+                pool.removeIf(KERNEL_BOX, [&](const StarPool::Star &) { ++hits; return false; });
+            g_sink = hits;
+            return iters;
+        });
+    }
+
+    {
+        auto sim = makeSim(n);
+        std::vector<StarPool::Star> stars;
+        sim->stars().forEach([&](const StarPool::Star &s) { stars.push_back(s); });
+        const Player &player = sim->player();
+        b.add(strprintf("Player::touches/%d", n), stars.size(), [&](std::uint64_t iters) {
+            std::size_t hits = 0;
+            for (std::uint64_t i = 0; i < iters; ++i)
+                for (const StarPool::Star &s : stars) {
+                    const StarBehaviour &sb = behaviour(s.kind);
+                    hits += player.touches(s.x, s.y, sb.width, sb.height);
+                }
+            g_sink = hits;
+            return iters * stars.size();
+        });
+    }
+
+    {
+        // a round trip through a snapshot, as rewinding or branching a game would do
+        auto sim = makeSim(n);
+        Snapshot snapshot;
+        b.add(strprintf("Simulation::save+restore/%d", n), sim->stars().size(), [&](std::uint64_t iters) {
+            for (std::uint64_t i = 0; i < iters; ++i) {
+                SnapshotWriter w(snapshot);
+                sim->save(w);
+                SnapshotReader r(snapshot);
+                if (!sim->restore(r))
+                    std::abort();
+            }
+            return iters;
+        });
+    }
+
+    {
+        /* What keeping the rewind history costs: ticked() takes a keyframe every DEFAULT_SIM_RATE /
+         * REWIND_KEYFRAMES_PER_SECOND ticks and only looks at tick() in between. Timed on its own, with no ticks
+         * run, by calling it at tick 0 over and over; with no room for a second keyframe, each call writes one and
+         * drops the one before, as a full history does. */
+        auto sim = makeSim(n);
+        Rewind rewind(DEFAULT_SIM_RATE, REWIND_SECONDS, 0);
+        rewind.start(*sim);
+        b.add(strprintf("Rewind::keyframe/%d", n), sim->stars().size(), [&](std::uint64_t iters) {
+            for (std::uint64_t i = 0; i < iters; ++i)
+                rewind.ticked(*sim);
+            return iters;
+        });
+    }
+
+    {
+        /* One frame's worth of rewinding at 60 frames per second, then the same ticks forwards again. The budget is
+         * made big enough for every keyframe of the second played first, twice over as the star count grows; the
+         * default one holds only a single keyframe at 100k stars, and stepping back would go nowhere. */
+        auto sim = makeSim(n);
+        Snapshot snapshot;
+        {
+            SnapshotWriter w(snapshot);
+            sim->save(w);
+        }
+        Rewind rewind(DEFAULT_SIM_RATE, REWIND_SECONDS,
+                      std::max(REWIND_BUDGET_BYTES, 2 * (REWIND_KEYFRAMES_PER_SECOND + 2) * snapshot.capacity()));
+        rewind.start(*sim);
+        for (unsigned i = 0; i < DEFAULT_SIM_RATE; ++i) {
+            sim->letObjectsInteract(dt);
+            rewind.ticked(*sim);
+        }
+        const unsigned step = DEFAULT_SIM_RATE / 60;
+        b.add(strprintf("Rewind::stepBack/%d", n), sim->stars().size(), [&](std::uint64_t iters) {
+            for (std::uint64_t i = 0; i < iters; ++i) {
+                if (rewind.stepBack(*sim, step) != step)
+                    std::abort();
+                for (unsigned t = 0; t < step; ++t) {
+                    sim->letObjectsInteract(dt);
+                    rewind.ticked(*sim);
+                }
+            }
+            return iters;
+        });
+    }
+}
+
+/// n random star positions spread over a screen
+struct KernelInput {
+    explicit KernelInput(unsigned n) : xs(n), ys(n) {
+        SpawnRng rng(SEED, n);
+        for (unsigned i = 0; i < n; ++i) {
+            xs[i] = rng.range(-int(SCREEN_WIDTH) / 2, SCREEN_WIDTH / 2) + rng.range(0, 99) / 100.0;
+            ys[i] = rng.range(-50, SCREEN_HEIGHT) + rng.range(0, 99) / 100.0;
+        }
+    }
+    std::vector<double> xs, ys;
+};
+
+constexpr StarKernels::Isa ALL_ISAS[] = {StarKernels::Isa::Scalar, StarKernels::Isa::SSE2, StarKernels::Isa::AVX2,
+                                         StarKernels::Isa::SIMD128};
+
+/// \return true if every supported instruction set gives bit-identical results to the scalar kernels
+bool checkKernels(unsigned n)
+{
+    const StarKernels::Isa restore = StarKernels::isa();
+    auto run = [&](StarKernels::Isa isa) {
+        StarKernels::select(isa);
+        KernelInput in(n);
+        std::vector<std::uint64_t> hits((n + 63) / 64);
+        const std::size_t count = StarKernels::overlap(in.xs.data(), in.ys.data(), n, KERNEL_BOX, hits.data());
+        return std::tuple(hits, count);
+    };
+    const auto expected = run(StarKernels::Isa::Scalar);
+    bool ok = true;
+    for (const StarKernels::Isa isa : ALL_ISAS)
+        if (StarKernels::supported(isa) && run(isa) != expected) {
+            std::cerr << "StarKernels: " << StarKernels::name(isa) << " results differ from scalar for " << n
+                      << " stars\n";
+            ok = false;
+        }
+    StarKernels::select(restore);
+    return ok;
+}
+
+void kernelBenchmarks(Bench &b, unsigned n)
+{
+    const StarKernels::Isa restore = StarKernels::isa();
+    for (const StarKernels::Isa isa : ALL_ISAS) {
+        if (!StarKernels::select(isa))
+            continue;
+        KernelInput in(n);
+        std::vector<std::uint64_t> hits((n + 63) / 64);
+        b.add(strprintf("StarKernels::overlap/%s/%d", StarKernels::name(isa), n), n, [&](std::uint64_t iters) {
+            std::size_t count = 0;
+            for (std::uint64_t i = 0; i < iters; ++i)
+                count += StarKernels::overlap(in.xs.data(), in.ys.data(), n, KERNEL_BOX, hits.data());
+            g_sink = count;
+            return iters * n;
+        });
+    }
+    StarKernels::select(restore);
+}
+
+#ifdef JUMPMAN_BENCH_RENDER
+/// A GraphicsEngine drawing offscreen, the star images loaded into it, and what its benchmarks' names are marked with
+struct RenderTarget {
+    GraphicsEngine &gfx;
+    std::array<ImageId, NUM_STAR_KINDS> star_images;
+    const char *mark;
+};
+
+void renderBenchmarks(Bench &b, const RenderTarget &t, unsigned n)
+{
+    GraphicsEngine &gfx = t.gfx;
+    auto sim = makeSim(n);
+    b.add(strprintf("GraphicsEngine::drawImage%s/%d", t.mark, n), sim->stars().size(), [&](std::uint64_t iters) {
+        for (std::uint64_t i = 0; i < iters; ++i) {
+            gfx.makeScreenBlack();
+            sim->stars().forEach([&](const StarPool::Star &s) {
+                const StarBehaviour &sb = behaviour(s.kind);
+                rect_t draw_to = {int(s.x), int(s.y), sb.width, sb.height};
+                rect_t draw_from = {s.imageX(), 0, draw_to.w, draw_to.h};
+                gfx.drawImage(t.star_images[std::size_t(s.kind)], &draw_from, &draw_to);
+            });
+            gfx.updateScreen(); // a renderer batches draws until it presents
+        }
+        return iters * sim->stars().size();
+    });
+    b.add(strprintf("GraphicsEngine::queueImage%s/%d", t.mark, n), sim->stars().size(), [&](std::uint64_t iters) {
+        for (std::uint64_t i = 0; i < iters; ++i) {
+            gfx.makeScreenBlack();
+            sim->stars().forEach([&](const StarPool::Star &s) {
+                const StarBehaviour &sb = behaviour(s.kind);
+                gfx.queueImage(t.star_images[std::size_t(s.kind)], {s.imageX(), 0, sb.width, sb.height},
+                               {int(s.x), int(s.y), sb.width, sb.height});
+            });
+            gfx.updateScreen();
+        }
+        return iters * sim->stars().size();
+    });
+}
+
+void textBenchmarks(Bench &b, const RenderTarget &t)
+{
+    GraphicsEngine &gfx = t.gfx;
+    b.add(strprintf("GraphicsEngine::drawText%s", t.mark), 0, [&](std::uint64_t iters) {
+        for (std::uint64_t i = 0; i < iters; ++i) {
+            TextBuffer<32> score;
+            score << "Score: " << i;
+            gfx.drawText(score.view(), 20);
+            gfx.drawText("Velocity: 42 m/s ", 20, WHITE, AlignRight, true);
+            gfx.updateScreen();
+        }
+        return iters * 2;
+    });
+}
+#endif
+
+std::string toJSON(const std::vector<Result> &results)
+{
+    std::string ret = "{\n  \"benchmarks\": [";
+    const char *sep = "\n";
+    for (const auto &r : results) {
+        ret += strprintf("%s    {\"name\": \"%s\", \"stars\": %d, \"ns_per_op\": %.3f, \"ops\": %d, \"relative\": %.6g}",
+                         sep, r.name, r.stars, r.ns_per_op, r.ops, r.relative);
+        sep = ",\n";
+    }
+    ret += "\n  ]\n}\n";
+    return ret;
+}
+
+/// Reads the name -> relative pairs back out of a file written by toJSON()
+std::optional<std::map<std::string, double>> loadBaseline(const std::string &filename)
+{
+    std::ifstream f(filename);
+    if (!f)
+        return std::nullopt;
+    const std::string json((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    std::map<std::string, double> ret;
+    constexpr std::string_view NAME = "\"name\": \"", RELATIVE = "\"relative\": ";
+    for (std::size_t pos = 0; (pos = json.find(NAME, pos)) != std::string::npos;) {
+        pos += NAME.size();
+        const std::size_t end = json.find('"', pos), rel = json.find(RELATIVE, pos);
+        if (end == std::string::npos || rel == std::string::npos || rel > json.find('}', pos))
+            return std::nullopt; // not one of ours, or from before results were relative
+        ret[json.substr(pos, end - pos)] = std::strtod(json.c_str() + rel + RELATIVE.size(), nullptr);
+    }
+    return ret;
+}
+
+/// \return the number of regressions; benchmarks missing from baseline are warned about, but don't count
+unsigned compareToBaseline(const std::vector<Result> &results, const std::map<std::string, double> &baseline,
+                           double tolerance)
+{
+    unsigned regressions = 0, missing = 0;
+    for (const auto &r : results) {
+        if (r.name == REFERENCE)
+            continue;
+        const auto it = baseline.find(r.name);
+        if (it == baseline.end() || it->second <= 0.0) {
+            ++missing;
+            std::cerr << strprintf("%-36s %10.4gx ref  not in baseline\n", r.name, r.relative);
+            continue;
+        }
+        const double change = r.relative / it->second - 1.0;
+        const bool regressed = change > tolerance;
+        regressions += regressed;
+        std::cerr << strprintf("%-36s %10.4gx ref  baseline %10.4gx  %+7.1f%%%s\n", r.name, r.relative, it->second,
+                               change * 100.0, regressed ? "  REGRESSION" : "");
+    }
+    if (missing)
+        std::cerr << "Warning: " << missing << " benchmark(s) not in the baseline, so not checked; regenerate it with"
+                  << " --out\n";
+    return regressions;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto opts = parseArgs(argc, argv);
+    if (!opts) return 1;
+
+    for (const unsigned n : opts->star_counts)
+        if (!checkKernels(n))
+            return 3;
+
+    Bench bench(*opts);
+    for (const unsigned n : opts->star_counts) {
+        simBenchmarks(bench, n);
+        kernelBenchmarks(bench, n);
+    }
+
+#ifdef JUMPMAN_BENCH_RENDER
+    for (const auto &[backend, mark] : {std::pair(RenderBackend::Surface, ""),
+                                        std::pair(RenderBackend::SoftwareRenderer, "[renderer]")}) {
+        GraphicsEngine gfx("Jumpman bench", SCREEN_WIDTH, SCREEN_HEIGHT, GraphicsEngine::Target::Offscreen, backend);
+        RenderTarget target{gfx, {}, mark};
+        bool loaded = true;
+        for (std::size_t kind = 0; kind < NUM_STAR_KINDS; ++kind)
+            loaded = loaded && (target.star_images[kind] = gfx.loadImage(STAR_BEHAVIOURS[kind].filename)) != NO_IMAGE;
+        if (!loaded) {
+            std::cerr << "Skipping " << gfx.backendName() << " rendering benchmarks: " << gfx.getLastError() << "\n";
+            continue;
+        }
+        for (const unsigned n : opts->star_counts)
+            renderBenchmarks(bench, target, n);
+        textBenchmarks(bench, target);
+    }
+#endif
+
+    const std::string json = toJSON(bench.results);
+    if (opts->out_file.empty())
+        std::cout << json;
+    else if (std::ofstream f(opts->out_file); !(f << json)) {
+        std::cerr << "Cannot write to: " << opts->out_file << "\n";
+        return 1;
+    }
+
+    if (!opts->baseline_file.empty()) {
+        const auto baseline = loadBaseline(opts->baseline_file);
+        if (!baseline) {
+            std::cerr << "Cannot read baseline: " << opts->baseline_file << "\n";
+            return 1;
+        }
+        if (const unsigned n = compareToBaseline(bench.results, *baseline, opts->tolerance)) {
+            std::cerr << n << " benchmark(s) regressed by more than " << opts->tolerance * 100.0 << "%\n";
+            return 2;
+        }
+    }
+    return 0;
+}
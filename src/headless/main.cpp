@@ -0,0 +1,383 @@
+/*!
+ * \file headless/main.cpp
+ * \brief Headless simulation runner: steps games as fast as possible without a window, audio or fonts
+ *
+ * \copyright GNU Public License
+ *
+ * Usage: jumpman_headless [--games N] [--max-ticks N] [--sim-rate N] [--seed N] [--threads N] [--stress N]
+ *                         [--script FILE] [--record FILE] [--trace FILE] [--isa ISA] [--warp] [--quiet]
+ *        jumpman_headless --replay FILE [--isa ISA] [--warp]
+ *
+ * Game number g is played with seed (--seed + g), so results are reproducible and independent of --threads.
+ * --stress N spawns N stars per row instead of 1; a screen holds about 13.7 * N stars, so 7300 is ~100k stars.
+ * --record saves the inputs of game 0 as a replay. --replay plays back a replay (recorded here or by the game)
+ * for as long as the recording lasts (--max-ticks does not apply) and exits with status 1 if the player dies at a
+ * different tick or with a different score than recorded, or dies before the recorded inputs run out. A recording
+ * of a game that was quit before it ended has no final tick and score, and can't be checked: that exits with
+ * status 2.
+ * --trace writes the profiler's zones as a Chrome trace on exit (needs a -DJUMPMAN_PROFILE=ON build).
+ * --isa picks the StarKernels instruction set (scalar, sse2, avx2 or simd128) instead of the best one the CPU
+ * supports. Results must not depend on it; replaying with each one is a quick check of that.
+ * --warp jumps from event to event with Simulation::fastForward() instead of running the collision tests every
+ * tick. It needs the inputs up front, so it works with --script and --replay but not the autopilot; results are
+ * the same either way.
+ *
+ * Without --script, games are driven by a trivial autopilot that jumps once and then steers toward the
+ * nearest star above the player. A script is a text file with one "<tick> <LEFT|RIGHT|UP|STILL>" per line,
+ * sorted by tick; lines starting with '#' are ignored. The same script is fed to every game.
+ */
+#include "Common.h"
+#include "FixedTimestep.h"
+#include "Profiler.h"
+#include "Replay.h"
+#include "Simulation.h"
+#include "StarKernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+using Input = Simulation::Input;
+
+struct ScriptEntry {
+    std::uint64_t tick;
+    Input input;
+};
+
+using Script = std::vector<ScriptEntry>;
+
+struct Options {
+    std::uint64_t games = 1;
+    std::uint64_t max_ticks = std::uint64_t(DEFAULT_SIM_RATE) * 60 * 10; // 10 minutes of game time
+    unsigned sim_rate = DEFAULT_SIM_RATE;
+    std::uint64_t seed = 1;
+    unsigned threads = 1;
+    unsigned stars_per_row = 1;
+    std::optional<Script> script;
+    std::string record_file;
+    std::string replay_file;
+    std::string trace_file;
+    bool warp = false;
+    bool quiet = false;
+};
+
+std::optional<Input> parseInput(std::string_view s)
+{
+    if (s == "LEFT") return Input::Left;
+    if (s == "RIGHT") return Input::Right;
+    if (s == "UP") return Input::Up;
+    if (s == "STILL") return Input::Still;
+    return std::nullopt;
+}
+
+std::optional<Script> loadScript(const std::string &filename)
+{
+    std::ifstream f(filename);
+    if (!f) {
+        std::cerr << "Cannot open script: " << filename << "\n";
+        return std::nullopt;
+    }
+    Script script;
+    std::string line;
+    for (unsigned lineno = 1; std::getline(f, line); ++lineno) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream ss(line);
+        std::uint64_t tick;
+        std::string name;
+        std::optional<Input> input;
+        if (!(ss >> tick >> name) || !(input = parseInput(name))
+                || (!script.empty() && tick < script.back().tick)) {
+            std::cerr << filename << ":" << lineno << ": bad script line: " << line << "\n";
+            return std::nullopt;
+        }
+        script.push_back({tick, *input});
+    }
+    return script;
+}
+
+std::optional<StarKernels::Isa> parseIsa(std::string_view s)
+{
+    using Isa = StarKernels::Isa;
+    for (Isa isa : {Isa::Scalar, Isa::SSE2, Isa::AVX2, Isa::SIMD128})
+        if (s == StarKernels::name(isa)) return isa;
+    return std::nullopt;
+}
+
+std::optional<Options> parseArgs(int argc, char **argv)
+{
+    Options opts;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        const bool has_val = i + 1 < argc;
+        if (arg == "--games" && has_val)
+            opts.games = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--max-ticks" && has_val)
+            opts.max_ticks = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--sim-rate" && has_val)
+            opts.sim_rate = std::max(std::atoi(argv[++i]), 1);
+        else if (arg == "--seed" && has_val)
+            opts.seed = std::strtoull(argv[++i], nullptr, 0);
+        else if (arg == "--threads" && has_val)
+            opts.threads = std::max(std::atoi(argv[++i]), 1);
+        else if (arg == "--stress" && has_val)
+            opts.stars_per_row = std::max(std::atoi(argv[++i]), 1);
+        else if (arg == "--script" && has_val) {
+            if (!(opts.script = loadScript(argv[++i])))
+                return std::nullopt;
+        } else if (arg == "--record" && has_val)
+            opts.record_file = argv[++i];
+        else if (arg == "--replay" && has_val)
+            opts.replay_file = argv[++i];
+        else if (arg == "--trace" && has_val)
+            opts.trace_file = argv[++i];
+        else if (arg == "--isa" && has_val) {
+            if (const auto isa = parseIsa(argv[++i]); !isa || !StarKernels::select(*isa)) {
+                std::cerr << "Unsupported --isa: " << argv[i] << "\n";
+                return std::nullopt;
+            }
+        } else if (arg == "--warp")
+            opts.warp = true;
+        else if (arg == "--quiet")
+            opts.quiet = true;
+        else {
+            std::cerr << "Unknown argument: " << arg << "\n"
+                      << "Usage: " << argv[0]
+                      << " [--games N] [--max-ticks N] [--sim-rate N] [--seed N] [--threads N] [--stress N]"
+                         " [--script FILE] [--record FILE] [--trace FILE] [--isa ISA] [--warp] [--quiet]\n"
+                      << "       " << argv[0] << " --replay FILE [--isa ISA] [--warp]\n";
+            return std::nullopt;
+        }
+    }
+    return opts;
+}
+
+/// Steer toward the nearest star above the player; of stars at the same height, the one nearest on the x-axis
+Input autopilot(const Simulation &sim)
+{
+    const Player &player = sim.player();
+    const double player_x = player.x(), player_y = player.y();
+    // (y, x-distance, x) of the best star so far; x only breaks exact ties, so storage order never matters
+    std::optional<std::tuple<double, double, double>> target;
+    auto consider = [&](const StarPool::Star &star) {
+        if (const std::tuple candidate(star.y, std::abs(star.x - player_x), star.x);
+            star.y > player_y && (!target || candidate < *target))
+            target = candidate;
+    };
+    /* Rows are 50 pixels apart, so the star wanted is nearly always just above the player: look in a band above
+     * it that doubles until the best star found is inside it, and only look at every star once the band is a
+     * few screens high. A --stress game has ~100k stars, and looking at all of them every tick took longer than
+     * the tick itself. */
+    constexpr double MAX_BAND = 4096;
+    for (double band = 64; !target; band *= 2) {
+        if (band > MAX_BAND) {
+            sim.stars().forEach(consider);
+            break;
+        }
+        sim.stars().forEachNear(player_y, player_y + band, 0.0, consider);
+        if (target && std::get<0>(*target) > player_y + band)
+            target.reset(); // forEachNear() may hand out stars outside the band; there may be nearer ones
+    }
+    if (!target || std::get<1>(*target) < player.width() / 2)
+        return Input::Still;
+    return std::get<2>(*target) < player.x() ? Input::Left : Input::Right;
+}
+
+struct GameResult {
+    std::size_t score = 0;
+    std::uint64_t ticks = 0;
+    bool died = false;
+};
+
+GameResult runGame(Simulation &sim, const Options &opts, std::uint64_t seed, double dt,
+                   ReplayWriter *recorder = nullptr)
+{
+    sim.reset(seed);
+
+    auto input = [&](std::uint64_t tick, Input in) {
+        sim.handleInput(in);
+        if (recorder) recorder->add(tick, ReplayEvent(in));
+    };
+
+    std::size_t next_script = 0;
+    std::optional<Input> last_autopilot;
+    bool died = false;
+    while (!died && sim.tick() < opts.max_ticks) {
+        const std::uint64_t tick = sim.tick();
+        if (opts.script) {
+            const Script &script = *opts.script;
+            for (; next_script < script.size() && script[next_script].tick <= tick; ++next_script)
+                input(tick, script[next_script].input);
+            // nothing changes the player's course before the next input or the next event
+            const std::uint64_t until =
+                std::min(next_script < script.size() ? script[next_script].tick : opts.max_ticks, opts.max_ticks);
+            if (opts.warp && sim.fastForward(dt, until - tick) > 0)
+                continue;
+        } else if (tick == 0) {
+            input(tick, Input::Up);
+        } else if (const Input in = autopilot(sim); in != last_autopilot) {
+            input(tick, in);
+            last_autopilot = in;
+        }
+        died = sim.letObjectsInteract(dt) == 1;
+    }
+    if (recorder && died)
+        recorder->finish(sim.tick(), sim.player().score());
+    return {sim.player().score(), sim.tick(), died};
+}
+
+/// Plays back a replay and checks that it ends the way it was recorded. \return the process exit code
+int verifyReplay(const Options &opts)
+{
+    ReplayReader replay(opts.replay_file);
+    if (!replay.ok()) {
+        std::cerr << replay.error() << "\n";
+        return 1;
+    }
+    const ReplayHeader &hdr = replay.header();
+    Simulation sim(hdr.screen_width, hdr.screen_height);
+    sim.reset(hdr.seed);
+    const double dt = FixedTimestep(hdr.sim_rate).tickDT();
+
+    // no tick limit: the recording's end record, or its last input if it has none, says when to stop
+    const auto t0 = std::chrono::steady_clock::now();
+    bool died = false;
+    while (!died) {
+        for (const ReplayReader::Entry *e; (e = replay.peek()) && e->tick <= sim.tick(); replay.pop())
+            if (const auto in = toSimInput(e->event))
+                sim.handleInput(*in);
+        if (!replay.ok()) {
+            std::cerr << replay.error() << "\n";
+            return 1;
+        }
+        if (!replay.peek() && !replay.end())
+            break; // out of inputs, and nothing says how the recorded game ended
+        if (replay.end() && sim.tick() > replay.end()->tick)
+            break; // should have died by now
+        if (opts.warp) {
+            const std::uint64_t until = replay.peek() ? replay.peek()->tick : replay.end()->tick + 1;
+            if (sim.fastForward(dt, until - sim.tick()) > 0)
+                continue;
+        }
+        died = sim.letObjectsInteract(dt) == 1;
+    }
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    const std::size_t score = sim.player().score();
+    std::cout << "replay: seed " << hdr.seed << ", score " << score << ", ticks " << sim.tick()
+              << (died ? "" : " (did not die)") << ", elapsed: " << secs << " s\n";
+    if (const ReplayReader::Entry *e = replay.peek()) {
+        std::cerr << "MISMATCH: died with recorded inputs still to come, the next at tick " << e->tick << "\n";
+        return 1;
+    }
+    const auto &end = replay.end();
+    if (!end && died) {
+        std::cerr << "MISMATCH: died, but the recorded game did not end\n";
+        return 1;
+    }
+    if (!end) {
+        std::cerr << "NOT VERIFIED: the recording has no end record (the game was quit before it ended), so there"
+                  << " is no final tick and score to check; played its inputs up to tick " << sim.tick() << "\n";
+        return 2;
+    }
+    if (!died || end->tick != sim.tick() || end->score != score) {
+        std::cerr << "MISMATCH: recorded score " << end->score << " at tick " << end->tick << "\n";
+        return 1;
+    }
+    std::cout << "OK: matches recording\n";
+    return 0;
+}
+
+int run(const Options &opts)
+{
+    if (!opts.replay_file.empty())
+        return verifyReplay(opts);
+
+    constexpr unsigned SCREEN_WIDTH = 1000, SCREEN_HEIGHT = 600;
+    const double dt = FixedTimestep(opts.sim_rate).tickDT();
+    std::vector<GameResult> results(opts.games);
+    std::atomic<std::uint64_t> next_game{0};
+
+    std::unique_ptr<ReplayWriter> recorder;
+    if (opts.warp && !opts.script) {
+        std::cerr << "--warp needs --script or --replay\n";
+        return 1;
+    }
+    if (!opts.record_file.empty() && opts.stars_per_row != 1) {
+        std::cerr << "--record cannot be combined with --stress\n";
+        return 1;
+    } else if (!opts.record_file.empty()) {
+        recorder = std::make_unique<ReplayWriter>(opts.record_file,
+                                                  ReplayHeader{opts.seed, opts.sim_rate, SCREEN_WIDTH, SCREEN_HEIGHT});
+        if (!recorder->ok()) {
+            std::cerr << "Cannot write to replay file: " << opts.record_file << "\n";
+            return 1;
+        }
+    }
+
+    // each thread owns its Simulation; games are handed out one at a time
+    auto worker = [&] {
+        Simulation sim(SCREEN_WIDTH, SCREEN_HEIGHT, opts.stars_per_row);
+        for (std::uint64_t g; (g = next_game++) < opts.games; )
+            results[g] = runGame(sim, opts, opts.seed + g, dt, g == 0 ? recorder.get() : nullptr);
+    };
+
+    const auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < opts.threads; ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (auto &t : threads)
+        t.join();
+    const double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    std::uint64_t total_ticks = 0;
+    std::size_t best_score = 0, total_score = 0;
+    for (std::uint64_t g = 0; g < opts.games; ++g) {
+        const GameResult &r = results[g];
+        total_ticks += r.ticks;
+        total_score += r.score;
+        best_score = std::max(best_score, r.score);
+        if (!opts.quiet)
+            std::cout << "game " << g << " (seed " << opts.seed + g << "): score " << r.score << ", ticks "
+                      << r.ticks << (r.died ? "" : " (tick limit reached)") << "\n";
+    }
+
+    std::cout << "games: " << opts.games << ", best score: " << best_score
+              << ", mean score: " << (opts.games ? double(total_score) / opts.games : 0.0)
+              << ", total ticks: " << total_ticks << ", elapsed: " << secs << " s"
+              << ", steps/sec: " << (secs > 0.0 ? total_ticks / secs : 0.0)
+              << ", kernels: " << StarKernels::name(StarKernels::isa()) << "\n";
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const auto opts = parseArgs(argc, argv);
+    if (!opts) return 1;
+
+    const int ret = run(*opts);
+
+    if (!opts->trace_file.empty() && !Profiler::WriteChromeTrace(opts->trace_file)) {
+        std::cerr << (Profiler::Enabled ? "Cannot write profiler trace to: " + opts->trace_file
+                                        : std::string("Profiling is not compiled in (configure with -DJUMPMAN_PROFILE=ON)"))
+                  << "\n";
+        return 1;
+    }
+    return ret;
+}
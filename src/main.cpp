@@ -1,10 +1,55 @@
 #include "Game.h"
+#include "GraphicsEngine.h"
 
 #include <SDL.h>
 
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+namespace {
+Game::Options parseArgs(int argc, char **argv)
+{
+    Game::Options opts;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--fps" && i + 1 < argc)
+            opts.frame_rate = std::max(std::atoi(argv[++i]), 1);
+        else if (arg == "--vsync")
+            opts.vsync = true;
+        else if (arg == "--renderer" && i + 1 < argc) {
+            const std::string_view name = argv[++i];
+            if (name == "surface")
+                opts.render_backend = RenderBackend::Surface;
+            else if (name == "auto")
+                opts.render_backend = RenderBackend::Renderer;
+            else if (name == "software")
+                opts.render_backend = RenderBackend::SoftwareRenderer;
+            else
+                Game::Warning("Unknown renderer (expected surface, auto or software): " + std::string(name));
+        } else if (arg == "--sim-rate" && i + 1 < argc)
+            opts.sim_rate = std::max(std::atoi(argv[++i]), 1);
+        else if (arg == "--seed" && i + 1 < argc)
+            opts.seed = std::strtoull(argv[++i], nullptr, 0);
+        else if (arg == "--record" && i + 1 < argc)
+            opts.record_file = argv[++i];
+        else if (arg == "--replay" && i + 1 < argc)
+            opts.replay_file = argv[++i];
+        else if (arg == "--frame-stats" && i + 1 < argc)
+            opts.frame_stats_file = argv[++i];
+        else if (arg == "--trace" && i + 1 < argc)
+            opts.trace_file = argv[++i];
+        else
+            Game::Warning("Unknown command-line argument: " + std::string(arg));
+    }
+    return opts;
+}
+} // namespace
+
 extern "C"
-int main(int, char **)
+int main(int argc, char **argv)
 {
     SDL_SetMainReady(); // tell libsdl we have our own main, so that it sets things up for us
-    return Game{}.run();
+    return Game{parseArgs(argc, argv)}.run();
 }
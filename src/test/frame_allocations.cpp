@@ -0,0 +1,198 @@
+/*!
+ * \file test/frame_allocations.cpp
+ * \brief Checks that steady-state frames don't allocate on the heap
+ *
+ * \copyright GNU Public License
+ *
+ * Plays frames the way Game does: a frame's worth of simulation ticks, then the HUD formatted by Hud, and a
+ * stretch of the game over screen with a name being typed into the high score table. When built along with the
+ * game, each frame is also drawn, with each backend, into an offscreen GraphicsEngine; that needs graphics/ in
+ * the current directory. Replaces operator new with one that counts, and exits with status 1 if any frame after
+ * the warm-up allocated.
+ */
+#define SDL_MAIN_HANDLED
+
+#include "Common.h"
+#include "FixedTimestep.h"
+#include "FrameTimeHistogram.h"
+#include "Hud.h"
+#include "Simulation.h"
+#ifdef JUMPMAN_TEST_RENDER
+#include "GraphicsEngine.h"
+#endif
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <string>
+#include <utility>
+
+namespace {
+
+constexpr unsigned SCREEN_WIDTH = 1000, SCREEN_HEIGHT = 600;
+constexpr std::uint64_t SEED = 1;
+
+/// Frames played before counting starts, and frames counted
+constexpr unsigned WARMUP_FRAMES = 10 * DEFAULT_FRAME_RATE, CHECKED_FRAMES = 60 * DEFAULT_FRAME_RATE;
+
+/// Number of rows of the high score table
+constexpr std::size_t HIGHSCORE_ROWS = 10;
+
+/// Heap allocations made so far, counted by the operator new below
+std::atomic<std::uint64_t> g_allocations{0};
+
+/// Keeps the compiler from optimizing away the text formatted
+volatile std::size_t g_sink;
+
+/// What a frame shows: the play area or the game over screen, with the text Hud formatted for it
+struct Frame {
+    const Simulation &sim;
+    std::array<std::string_view, 3> hud; ///< score, velocity and frame stats
+    std::array<std::string_view, HIGHSCORE_ROWS> rows; ///< the high score table; empty unless the game is over
+    const std::string &nick;
+};
+
+/*!
+ * \brief Play WARMUP_FRAMES + CHECKED_FRAMES frames, passing each to draw
+ *
+ * The player jumps and falls through a game, which starts again when it dies. Every fourth second is a game over
+ * screen, where a 5-letter name is typed into the high score table one letter at a time, and deleted again.
+ * \return the number of allocations made by the frames after the warm-up
+ */
+std::uint64_t playFrames(const std::function<void(const Frame &)> &draw)
+{
+    const double dt = FixedTimestep(DEFAULT_SIM_RATE).tickDT();
+    Simulation sim(SCREEN_WIDTH, SCREEN_HEIGHT);
+    sim.reset(SEED);
+    sim.addStars();
+    Hud hud(HIGHSCORE_ROWS);
+    FrameTimeHistogram recent_stats(25.0), shown_stats(25.0);
+    std::array<std::pair<std::size_t, std::string>, HIGHSCORE_ROWS> highscore;
+    for (std::size_t i = 0; i < HIGHSCORE_ROWS; ++i)
+        highscore[i] = {(HIGHSCORE_ROWS - i) * 1000, std::string("ABCDE").substr(0, i % 5 + 1)};
+    std::string nick;
+    nick.reserve(5);
+
+    std::uint64_t allocations = 0;
+    for (unsigned frame = 0; frame < WARMUP_FRAMES + CHECKED_FRAMES; ++frame) {
+        const std::uint64_t before = g_allocations;
+        const bool game_over = frame / DEFAULT_FRAME_RATE % 4 == 3;
+        Frame f{sim, {}, {}, nick};
+        if (!game_over) {
+            for (unsigned t = 0; t < DEFAULT_SIM_RATE / DEFAULT_FRAME_RATE; ++t) {
+                if (sim.tick() == 0)
+                    sim.handleInput(Simulation::Input::Up);
+                if (sim.letObjectsInteract(dt) == 1) {
+                    sim.reset(SEED + frame);
+                    sim.addStars();
+                }
+            }
+        } else {
+            // type a letter every 6 frames, then start again
+            if (frame % 6 == 0) {
+                if (nick.size() < 5)
+                    nick += char('A' + frame % 26);
+                else
+                    nick.clear();
+            }
+            for (std::size_t i = 0; i < HIGHSCORE_ROWS; ++i) {
+                const auto &[score, name] = highscore[i];
+                f.rows[i] = hud.highscoreRow(i, i == 3 && !nick.empty() ? nick : name, score);
+            }
+        }
+        recent_stats.record(1000.0 / DEFAULT_FRAME_RATE + frame % 7);
+        if (frame % DEFAULT_FRAME_RATE == 0) {
+            shown_stats = recent_stats;
+            recent_stats.clear();
+        }
+        const Player &player = sim.player();
+        f.hud = {hud.score(player.score()), hud.velocity(player.velocity()),
+                 hud.frameStats(shown_stats, (frame % 13) / 10.0)};
+        draw(f);
+        if (frame >= WARMUP_FRAMES)
+            allocations += g_allocations - before;
+    }
+    return allocations;
+}
+
+/// \return true, after saying so, if the frames played by playFrames() with draw made no allocations
+bool check(const std::string &what, const std::function<void(const Frame &)> &draw)
+{
+    const std::uint64_t allocations = playFrames(draw);
+    if (allocations)
+        std::cerr << what << ": " << allocations << " heap allocation(s) in " << CHECKED_FRAMES
+                  << " steady-state frames\n";
+    else
+        std::cerr << what << ": no heap allocations in " << CHECKED_FRAMES << " steady-state frames\n";
+    return allocations == 0;
+}
+
+} // namespace
+
+/* Count every allocation; the other forms of operator new and delete call these */
+void *operator new(std::size_t size)
+{
+    ++g_allocations;
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+
+void operator delete(void *p, std::size_t) noexcept { std::free(p); }
+
+int main()
+{
+    bool ok = check("Hud", [](const Frame &f) {
+        std::size_t n = 0;
+        for (const std::string_view text : f.hud)
+            n += text.size();
+        for (const std::string_view text : f.rows)
+            n += text.size();
+        g_sink = n;
+    });
+
+#ifdef JUMPMAN_TEST_RENDER
+    for (const auto &[backend, name] : {std::pair(RenderBackend::Surface, "Hud+surface"),
+                                        std::pair(RenderBackend::SoftwareRenderer, "Hud+renderer")}) {
+        GraphicsEngine gfx("Jumpman test", SCREEN_WIDTH, SCREEN_HEIGHT, GraphicsEngine::Target::Offscreen, backend);
+        std::array<ImageId, NUM_STAR_KINDS> star_images{};
+        for (std::size_t kind = 0; kind < NUM_STAR_KINDS; ++kind)
+            if ((star_images[kind] = gfx.loadImage(STAR_BEHAVIOURS[kind].filename)) == NO_IMAGE) {
+                std::cerr << name << ": " << gfx.getLastError() << "\n";
+                return 1;
+            }
+        // the same calls as Game::drawObjectsToScreen() and Game::drawGameOverScreen() make
+        ok = check(name, [&](const Frame &f) {
+            gfx.makeScreenBlack();
+            const double camera_y = f.sim.lerpCameraY(1.0);
+            f.sim.stars().forEach([&](const StarPool::Star &s) {
+                const StarBehaviour &sb = behaviour(s.kind);
+                gfx.queueImage(star_images[std::size_t(s.kind)], {s.imageX(), 0, sb.width, sb.height},
+                               {int(s.x), int(s.y - camera_y), sb.width, sb.height});
+            });
+            gfx.drawText(f.hud[0], 20);
+            gfx.drawText(f.hud[1], 20, WHITE, AlignRight, true);
+            gfx.drawText(f.hud[2], SCREEN_HEIGHT * 2 - 20, GREEN, AlignLeft, true, true);
+            unsigned y = 300;
+            for (const std::string_view row : f.rows)
+                if (!row.empty()) {
+                    gfx.drawText(row, y, YELLOW);
+                    y += 40;
+                }
+            if (!f.rows[0].empty())
+                gfx.drawText(f.nick.empty() ? std::string_view(" ") : std::string_view(f.nick), SCREEN_HEIGHT + 250,
+                             ORANGE);
+            gfx.updateScreen();
+        }) && ok;
+    }
+#endif
+
+    return ok ? 0 : 1;
+}